@@ -0,0 +1,76 @@
+#include <rbtree.h>
+
+#include "bench.h"
+
+// 삽입/삭제가 오래 섞인 트리에서 rbtree_compact 전후의 scan(to_array)과 find 속도, 메모리 사용량을 비교한다.
+// n개를 넣은 뒤 무작위 erase와 insert를 n번씩 반복해 node를 흩어 놓는다.
+// 사용법: bench-compact [max_n]   (기본 1000000, 1000부터 10배씩)
+
+#define PAGE_KEYS 4096
+
+static void report_memory(const rbtree *t, const char *impl, const size_t n) {
+  rbtree_memory_t mem;
+  rbtree_memory_usage(t, &mem);
+  printf("{\"impl\":\"%s\",\"op\":\"memory\",\"dist\":\"random\",\"n\":%zu,\"nodes\":%zu,\"free_nodes\":%zu,"
+         "\"slabs\":%zu,\"bytes\":%zu,\"fragmentation\":%.3f}\n",
+         impl, n, mem.nodes, mem.free_nodes, mem.slabs, mem.bytes, mem.fragmentation);
+}
+
+static void bench_scan_find(const rbtree *t, const char *impl, const key_t *probes, key_t *page, const size_t n) {
+  bench_stat s;
+  volatile size_t sink = 0;
+
+  const size_t pages = (n + PAGE_KEYS - 1) / PAGE_KEYS;
+  rbtree_cursor cursor = {NULL, 0};
+  BENCH_LOOP(&s, pages, i, sink += rbtree_to_array_batch(t, &cursor, page, PAGE_KEYS));
+  bench_report(&s, impl, "to_array_page", "random", n);
+
+  BENCH_LOOP(&s, n, i, sink += (rbtree_find(t, probes[i]) != NULL));
+  bench_report(&s, impl, "find", "random", n);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t max_n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+  for (size_t n = 1000; n <= max_n; n *= 10) {
+    key_t *keys = (key_t *)malloc(n * sizeof(key_t));
+    key_t *probes = (key_t *)malloc(n * sizeof(key_t));
+    key_t *page = (key_t *)malloc(PAGE_KEYS * sizeof(key_t));
+    uint64_t rng = 42;
+    bench_stat s;
+
+    if (keys == NULL || probes == NULL || page == NULL) {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+
+    rbtree *t = new_rbtree();
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = (key_t)(bench_rand(&rng) >> 33);
+      rbtree_insert(t, keys[i]);
+    }
+    // 지운 자리는 free list를 거쳐 무작위 순서로 다시 쓰인다
+    for (size_t i = 0; i < n; i++) {
+      const size_t j = bench_rand(&rng) % n;
+      rbtree_erase(t, rbtree_find(t, keys[j]));
+      keys[j] = (key_t)(bench_rand(&rng) >> 33);
+      rbtree_insert(t, keys[j]);
+    }
+    for (size_t i = 0; i < n; i++) probes[i] = keys[bench_rand(&rng) % n];
+
+    report_memory(t, "churned", n);
+    bench_scan_find(t, "churned", probes, page, n);
+
+    BENCH_LOOP(&s, 1, i, rbtree_compact(t));
+    bench_report(&s, "compacted", "compact", "random", n);
+
+    report_memory(t, "compacted", n);
+    bench_scan_find(t, "compacted", probes, page, n);
+
+    delete_rbtree(t);
+    free(page);
+    free(probes);
+    free(keys);
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include <pthread.h>
+#include <rbtree_concurrent.h>
+#include <rbtree_sharded.h>
+
+#include "bench.h"
+
+// rbtree 전체를 mutex 하나로 감싼 방식, crbtree(seqlock 읽기), rbtree_sharded의
+// thread 수별 처리량 비교
+// 사용법: bench-concurrent [max_threads] [write_percent]   (기본 64, 10)
+
+#define TREE_KEYS 1000000
+#define OPS_PER_THREAD 200000
+#define SHARDS 64
+
+typedef enum { IMPL_MUTEX, IMPL_CRBTREE, IMPL_SHARDED, IMPL_COUNT } impl_t;
+
+static const char *impl_names[IMPL_COUNT] = {"mutex", "crbtree", "sharded"};
+
+typedef struct {
+  impl_t impl;
+  crbtree *c;
+  rbtree_sharded *sh;
+  rbtree *t;
+  pthread_mutex_t *lock;
+  int write_percent;
+  uint64_t seed;
+} worker_arg;
+
+static void *worker(void *p) {
+  worker_arg *a = (worker_arg *)p;
+  uint64_t rng = a->seed;
+  volatile size_t sink = 0;
+
+  for (int i = 0; i < OPS_PER_THREAD; i++) {
+    const uint64_t r = bench_rand(&rng);
+    const key_t key = (key_t)((r >> 8) % (2 * TREE_KEYS));
+    const int write = (int)(r % 100) < a->write_percent;
+
+    if (a->impl == IMPL_CRBTREE) {
+      if (!write)           sink += crbtree_contains(a->c, key);
+      else if (r & 0x80)    crbtree_insert(a->c, key);
+      else                  crbtree_erase(a->c, key);
+    } else if (a->impl == IMPL_SHARDED) {
+      if (!write)           sink += rbtree_sharded_contains(a->sh, key);
+      else if (r & 0x80)    rbtree_sharded_insert(a->sh, key);
+      else                  rbtree_sharded_erase(a->sh, key);
+    } else {
+      pthread_mutex_lock(a->lock);
+      if (!write) {
+        sink += rbtree_find(a->t, key) != NULL;
+      } else if (r & 0x80) {
+        rbtree_insert(a->t, key);
+      } else {
+        node_t *n = rbtree_find(a->t, key);
+        if (n != NULL) rbtree_erase(a->t, n);
+      }
+      pthread_mutex_unlock(a->lock);
+    }
+  }
+  return NULL;
+}
+
+static void run(const impl_t impl, const int threads, const int write_percent) {
+  crbtree *c = NULL;
+  rbtree_sharded *sh = NULL;
+  rbtree *t = NULL;
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+  if (impl == IMPL_CRBTREE) {
+    c = new_crbtree();
+    for (key_t k = 0; k < 2 * TREE_KEYS; k += 2) crbtree_insert(c, k);
+  } else if (impl == IMPL_SHARDED) {
+    sh = new_rbtree_sharded(SHARDS, RBTREE_SHARD_BY_HASH);
+    for (key_t k = 0; k < 2 * TREE_KEYS; k += 2) rbtree_sharded_insert(sh, k);
+  } else {
+    t = new_rbtree();
+    for (key_t k = 0; k < 2 * TREE_KEYS; k += 2) rbtree_insert(t, k);
+  }
+
+  pthread_t tid[threads];
+  worker_arg args[threads];
+  const uint64_t t0 = bench_now_ns();
+  for (int i = 0; i < threads; i++) {
+    args[i] = (worker_arg){impl, c, sh, t, &lock, write_percent, (uint64_t)i * 7919 + 1};
+    pthread_create(&tid[i], NULL, worker, &args[i]);
+  }
+  for (int i = 0; i < threads; i++) pthread_join(tid[i], NULL);
+  const double sec = (bench_now_ns() - t0) * 1e-9;
+
+  printf("{\"impl\":\"%s\",\"op\":\"mixed\",\"threads\":%d,\"write_percent\":%d,"
+         "\"ops\":%d,\"ops_per_sec\":%.0f}\n",
+         impl_names[impl], threads, write_percent,
+         threads * OPS_PER_THREAD, threads * OPS_PER_THREAD / sec);
+  fflush(stdout);
+
+  delete_crbtree(c);
+  delete_rbtree_sharded(sh);
+  delete_rbtree(t);
+}
+
+int main(int argc, char *argv[]) {
+  const int max_threads = (argc > 1) ? atoi(argv[1]) : 64;
+  const int write_percent = (argc > 2) ? atoi(argv[2]) : 10;
+
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    for (int impl = 0; impl < IMPL_COUNT; impl++) run((impl_t)impl, threads, write_percent);
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include <rbtree.h>
+
+#include "bench.h"
+
+// 중복이 많은 입력에서 counted 트리와 key마다 node를 만드는 rbtree를 비교한다.
+// key는 distinct개의 값 중에서 Zipf 비슷하게(작은 값일수록 자주) 고른다.
+// 메모리는 트리에 남은 node 수 x sizeof(node_t)로 센다.
+// 사용법: bench-counted [n] [distinct]   (기본 1000000, 1000)
+
+static void report_memory(const char *impl, const size_t n, const rbtree *t) {
+  size_t nodes = 0;
+  for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_next(t, p)) nodes++;
+  printf("{\"impl\":\"%s\",\"op\":\"memory\",\"n\":%zu,\"nodes\":%zu,\"bytes\":%zu}\n", impl, n, nodes,
+         nodes * sizeof(node_t));
+  fflush(stdout);
+}
+
+static void bench_tree(rbtree *t, const char *impl, const key_t *keys, const size_t n) {
+  bench_stat s;
+  volatile size_t sink = 0;
+
+  BENCH_LOOP(&s, n, i, rbtree_insert(t, keys[i]));
+  bench_report(&s, impl, "insert", "duplicate", n);
+  report_memory(impl, n, t);
+
+  BENCH_LOOP(&s, n, i, sink += (rbtree_find(t, keys[i]) != NULL));
+  bench_report(&s, impl, "find", "duplicate", n);
+
+  BENCH_LOOP(&s, n, i, sink += rbtree_rank(t, keys[i]));
+  bench_report(&s, impl, "rank", "duplicate", n);
+
+  BENCH_LOOP(&s, n, i, rbtree_erase(t, rbtree_find(t, keys[i])));
+  bench_report(&s, impl, "erase", "duplicate", n);
+
+  delete_rbtree(t);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t distinct = (argc > 2 && strtoul(argv[2], NULL, 10) > 0) ? strtoul(argv[2], NULL, 10) : 1000;
+  key_t *keys = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+  uint64_t rng = 42;
+
+  if (keys == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  // 두 균등 난수의 곱: 작은 key에 몰리는 분포
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = (key_t)((bench_rand(&rng) % distinct) * (bench_rand(&rng) % distinct) / distinct);
+  }
+
+  bench_tree(new_rbtree(), "rbtree", keys, n);
+  bench_tree(new_rbtree_counted(), "counted", keys, n);
+
+  free(keys);
+  return 0;
+}
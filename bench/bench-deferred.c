@@ -0,0 +1,37 @@
+#include <rbtree_deferred.h>
+
+#include "bench.h"
+
+// 트리를 버릴 때 호출한 thread가 멈추는 시간: delete_rbtree와 rbtree_delete_deferred 비교.
+// 크기마다 같은 모양의 트리를 REPS개씩 만들어 하나씩 버리고, deferred는 마지막에 flush까지 잰다.
+// 사용법: bench-deferred [max_n]   (기본 1000000, 1000부터 10배씩)
+
+#define REPS 8
+
+static rbtree *make_tree(const size_t n, uint64_t *rng) {
+  rbtree *t = new_rbtree();
+  for (size_t i = 0; i < n; i++) rbtree_insert(t, (key_t)bench_rand(rng));
+  return t;
+}
+
+int main(int argc, char *argv[]) {
+  const size_t max_n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  rbtree *trees[REPS];
+  uint64_t rng = 42;
+  bench_stat s;
+
+  for (size_t n = 1000; n <= max_n; n *= 10) {
+    for (int i = 0; i < REPS; i++) trees[i] = make_tree(n, &rng);
+    BENCH_LOOP(&s, REPS, i, delete_rbtree(trees[i]));
+    bench_report(&s, "rbtree", "delete", "random", n);
+
+    for (int i = 0; i < REPS; i++) trees[i] = make_tree(n, &rng);
+    const uint64_t t0 = bench_now_ns();
+    BENCH_LOOP(&s, REPS, i, rbtree_delete_deferred(trees[i]));
+    bench_report(&s, "deferred", "delete", "random", n);
+    rbtree_deferred_flush();
+    printf("{\"impl\":\"deferred\",\"op\":\"flush\",\"dist\":\"random\",\"n\":%zu,\"total_ns\":%llu}\n", n,
+           (unsigned long long)(bench_now_ns() - t0));
+  }
+  return 0;
+}
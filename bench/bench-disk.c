@@ -0,0 +1,70 @@
+#include <rbtree_disk.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// 재시작 비용 비교: 모든 key를 rbtree_insert로 다시 넣는 경우와
+// rbtree_save로 저장한 파일을 rbtree_load_mmap으로 여는 경우.
+// 열어 둔 mapping에서의 find와 처음 쓰기 때의 copy-on-write 비용도 함께 잰다.
+// 사용법: bench-disk [n] [path]   (기본 1000000, /tmp/bench-disk.rbt)
+
+static void report_ms(const char *impl, const char *op, const size_t n, const uint64_t ns) {
+  printf("{\"impl\":\"%s\",\"op\":\"%s\",\"n\":%zu,\"ms\":%.3f}\n", impl, op, n, ns * 1e-6);
+  fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  const char *path = (argc > 2) ? argv[2] : "/tmp/bench-disk.rbt";
+  key_t *keys = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+  key_t *probes = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+  uint64_t rng = 42;
+  uint64_t t0;
+
+  if (keys == NULL || probes == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) keys[i] = (key_t)(bench_rand(&rng) >> 33);
+  for (size_t i = 0; i < n; i++) probes[i] = keys[bench_rand(&rng) % n];
+
+  t0 = bench_now_ns();
+  rbtree *t = new_rbtree();
+  for (size_t i = 0; i < n; i++) rbtree_insert(t, keys[i]);
+  report_ms("rbtree", "reinsert", n, bench_now_ns() - t0);
+
+  t0 = bench_now_ns();
+  if (rbtree_save(t, path) != 0) {
+    perror("rbtree_save");
+    return 1;
+  }
+  report_ms("disk", "save", n, bench_now_ns() - t0);
+
+  t0 = bench_now_ns();
+  rbtree_mapped *m = rbtree_load_mmap(path);
+  if (m == NULL) {
+    perror("rbtree_load_mmap");
+    return 1;
+  }
+  report_ms("disk", "load_mmap", n, bench_now_ns() - t0);
+
+  bench_stat s;
+  volatile size_t sink = 0;
+
+  BENCH_LOOP(&s, n, i, sink += (rbtree_find(t, probes[i]) != NULL));
+  bench_report(&s, "rbtree", "find", "random", n);
+
+  BENCH_LOOP(&s, n, i, sink += rbtree_mapped_contains(m, probes[i]));
+  bench_report(&s, "disk", "find", "random", n);
+
+  t0 = bench_now_ns();
+  rbtree_mapped_insert(m, 0);
+  report_ms("disk", "promote", n, bench_now_ns() - t0);
+
+  delete_rbtree_mapped(m);
+  delete_rbtree(t);
+  unlink(path);
+  free(probes);
+  free(keys);
+  return 0;
+}
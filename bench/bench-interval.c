@@ -0,0 +1,63 @@
+#include <rbtree_interval.h>
+
+#include "bench.h"
+
+// [a, b]와 겹치는 구간 찾기: interval tree와 배열 전체를 훑는 linear scan 비교.
+// 구간은 [0, 16n)에서 시작하고 대부분 짧으며 가끔 긴 구간이 섞인 time range 형태다.
+// scan은 질의당 O(n)이므로 질의 수를 줄여서 잰다.
+// 사용법: bench-interval [n] [queries]   (기본 1000000, 100000)
+
+typedef struct {
+  key_t lo, hi;
+} interval_t;
+
+static int count_visit(ivnode_t *x, void *arg) {
+  (void)x;
+  (*(size_t *)arg)++;
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  const size_t queries = (argc > 2) ? strtoul(argv[2], NULL, 10) : 100000;
+  const size_t scan_queries = (queries < 1000) ? queries : 1000;
+  const key_t span = (key_t)(16 * n + 1);
+  interval_t *all = (interval_t *)malloc((n > 0 ? n : 1) * sizeof(interval_t));
+  interval_t *q = (interval_t *)malloc((queries > 0 ? queries : 1) * sizeof(interval_t));
+  uint64_t rng = 42;
+  bench_stat s;
+  volatile size_t sink = 0;
+
+  if (all == NULL || q == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) {
+    all[i].lo = (key_t)(bench_rand(&rng) % span);
+    all[i].hi = all[i].lo + (key_t)((bench_rand(&rng) % 100 == 0) ? bench_rand(&rng) % 10000 : bench_rand(&rng) % 64);
+  }
+  for (size_t i = 0; i < queries; i++) {
+    q[i].lo = (key_t)(bench_rand(&rng) % span);
+    q[i].hi = q[i].lo + (key_t)(bench_rand(&rng) % 256);
+  }
+
+  rbtree_interval *t = new_rbtree_interval();
+  BENCH_LOOP(&s, n, i, rbtree_interval_insert(t, all[i].lo, all[i].hi));
+  bench_report(&s, "interval", "insert", "random", n);
+
+  size_t found = 0;
+  BENCH_LOOP(&s, queries, i, rbtree_interval_overlaps(t, q[i].lo, q[i].hi, count_visit, &found));
+  bench_report(&s, "interval", "overlaps", "random", n);
+  printf("{\"impl\":\"interval\",\"op\":\"overlaps\",\"n\":%zu,\"avg_k\":%.2f}\n", n,
+         queries > 0 ? (double)found / queries : 0.0);
+
+  BENCH_LOOP(&s, scan_queries, i, {
+    for (size_t j = 0; j < n; j++) sink += (all[j].lo <= q[i].hi && q[i].lo <= all[j].hi);
+  });
+  bench_report(&s, "scan", "overlaps", "random", n);
+
+  delete_rbtree_interval(t);
+  free(q);
+  free(all);
+  return 0;
+}
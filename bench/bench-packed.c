@@ -0,0 +1,66 @@
+#include <rbtree.h>
+#include <rbtree_packed.h>
+
+#include "bench.h"
+
+// rbtree(node_t + sentinel)와 compact 모드(prbtree, irbtree)의 insert/find/erase 비교.
+// node 크기는 rbtree 40byte, prbtree 32byte(color bit를 빼도 padding 때문에 줄지 않음), irbtree 16byte.
+// 사용법: bench-packed [max_n]   (기본 max_n = 1000000)
+
+static void bench_rbtree(const key_t *keys, const size_t n) {
+  rbtree *t = new_rbtree();
+  volatile size_t found = 0;
+  bench_stat s;
+
+  BENCH_LOOP(&s, n, i, rbtree_insert(t, keys[i]));
+  bench_report(&s, "rbtree", "insert", "random", n);
+  BENCH_LOOP(&s, n, i, found += rbtree_find(t, keys[i]) != NULL);
+  bench_report(&s, "rbtree", "find", "random", n);
+  BENCH_LOOP(&s, n, i, rbtree_erase(t, rbtree_find(t, keys[i])));
+  bench_report(&s, "rbtree", "erase", "random", n);
+  delete_rbtree(t);
+}
+
+static void bench_prbtree(const key_t *keys, const size_t n) {
+  prbtree *t = new_prbtree();
+  volatile size_t found = 0;
+  bench_stat s;
+
+  BENCH_LOOP(&s, n, i, prbtree_insert(t, keys[i]));
+  bench_report(&s, "prbtree", "insert", "random", n);
+  BENCH_LOOP(&s, n, i, found += prbtree_find(t, keys[i]) != NULL);
+  bench_report(&s, "prbtree", "find", "random", n);
+  BENCH_LOOP(&s, n, i, prbtree_erase(t, prbtree_find(t, keys[i])));
+  bench_report(&s, "prbtree", "erase", "random", n);
+  delete_prbtree(t);
+}
+
+static void bench_irbtree(const key_t *keys, const size_t n) {
+  irbtree *t = new_irbtree();
+  volatile size_t found = 0;
+  bench_stat s;
+
+  BENCH_LOOP(&s, n, i, irbtree_insert(t, keys[i]));
+  bench_report(&s, "irbtree", "insert", "random", n);
+  BENCH_LOOP(&s, n, i, found += irbtree_find(t, keys[i]) != IRBTREE_NIL);
+  bench_report(&s, "irbtree", "find", "random", n);
+  BENCH_LOOP(&s, n, i, irbtree_erase(t, irbtree_find(t, keys[i])));
+  bench_report(&s, "irbtree", "erase", "random", n);
+  delete_irbtree(t);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t max_n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+  for (size_t n = 10000; n <= max_n; n *= 10) {
+    key_t *keys = (key_t *)malloc(n * sizeof(key_t));
+    uint64_t rng = 1;
+    for (size_t i = 0; i < n; i++) keys[i] = (key_t)(bench_rand(&rng) >> 33);
+
+    bench_rbtree(keys, n);
+    bench_prbtree(keys, n);
+    bench_irbtree(keys, n);
+    free(keys);
+  }
+  return 0;
+}
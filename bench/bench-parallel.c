@@ -0,0 +1,118 @@
+#include <rbtree_parallel.h>
+
+#include "bench.h"
+
+// 두 n개짜리 트리의 union, intersection, difference와 정렬된 배열로부터의 build, to_array를
+// thread 수별로 측정한다. threads 0은 pool 없이(NULL) 순차 실행한 기준값이고,
+// "insert" impl은 같은 결과를 rbtree_insert/rbtree_erase 반복으로 만든 기준값이다.
+// 사용법: bench-parallel [n] [max_threads]   (기본 1000000, 64)
+
+typedef enum { OP_UNION, OP_INTERSECTION, OP_DIFFERENCE, OP_BUILD, OP_TO_ARRAY, OP_COUNT } op_t;
+
+static const char *op_names[OP_COUNT] = {"union", "intersection", "difference", "build", "to_array"};
+
+static key_t *keys_a, *keys_b;
+
+// 두 트리는 key의 절반 정도를 공유하도록 [0, 2n)에서 고른다
+static void make_keys(const size_t n) {
+  uint64_t rng = 42;
+
+  keys_a = (key_t *)malloc(n * sizeof(key_t));
+  keys_b = (key_t *)malloc(n * sizeof(key_t));
+  if (keys_a == NULL || keys_b == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) {
+    keys_a[i] = (key_t)(bench_rand(&rng) % (2 * n));
+    keys_b[i] = (key_t)(bench_rand(&rng) % (2 * n));
+  }
+}
+
+static rbtree *make_tree(const key_t *keys, const size_t n) {
+  rbtree *t = new_rbtree_with_capacity(n);
+  for (size_t i = 0; i < n; i++) rbtree_insert(t, keys[i]);
+  return t;
+}
+
+static void report(const char *impl, const op_t op, const int threads, const size_t n, const uint64_t ns) {
+  const double keys = (op == OP_BUILD || op == OP_TO_ARRAY) ? n : 2.0 * n;  // 집합 연산은 두 트리의 key 수
+
+  printf("{\"impl\":\"%s\",\"op\":\"%s\",\"threads\":%d,\"n\":%zu,\"ms\":%.3f,\"keys_per_sec\":%.0f}\n",
+         impl, op_names[op], threads, n, ns * 1e-6, keys / (ns * 1e-9));
+  fflush(stdout);
+}
+
+static void run(const op_t op, const int threads, const size_t n) {
+  rbtree_pool *pool = (threads > 0) ? new_rbtree_pool((size_t)threads) : NULL;
+  rbtree *a = NULL, *b = NULL;
+  key_t *arr = NULL;
+  uint64_t t0;
+
+  if (op == OP_BUILD || op == OP_TO_ARRAY) {
+    arr = (key_t *)malloc(n * sizeof(key_t));
+    if (arr == NULL) {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++) arr[i] = (key_t)(2 * i);
+    if (op == OP_TO_ARRAY) a = rbtree_from_sorted_array(arr, n);
+  } else {
+    a = make_tree(keys_a, n);
+    b = make_tree(keys_b, n);
+  }
+
+  t0 = bench_now_ns();
+  switch (op) {
+    case OP_UNION:        rbtree_union(pool, a, b); break;
+    case OP_INTERSECTION: rbtree_intersection(pool, a, b); break;
+    case OP_DIFFERENCE:   rbtree_difference(pool, a, b); break;
+    case OP_BUILD:        a = rbtree_from_sorted_array_parallel(pool, arr, n); break;
+    case OP_TO_ARRAY:     rbtree_to_array_parallel(pool, a, arr, n); break;
+    default: break;
+  }
+  report("parallel", op, threads, n, bench_now_ns() - t0);
+
+  delete_rbtree(a);
+  delete_rbtree(b);
+  free(arr);
+  delete_rbtree_pool(pool);
+}
+
+// 한 thread에서 node 단위 연산으로 같은 결과를 만드는 기준값
+static void run_baseline(const op_t op, const size_t n) {
+  rbtree *a = make_tree(keys_a, n);
+  rbtree *b = make_tree(keys_b, n);
+  const uint64_t t0 = bench_now_ns();
+
+  if (op == OP_UNION) {
+    for (node_t *p = rbtree_min(b); p != NULL; p = rbtree_next(b, p)) rbtree_insert(a, p->key);
+  } else {
+    node_t *p = rbtree_min(a);
+    while (p != NULL) {
+      node_t *next = rbtree_next(a, p);
+      if ((rbtree_find(b, p->key) != NULL) != (op == OP_INTERSECTION)) rbtree_erase(a, p);
+      p = next;
+    }
+  }
+  report("insert", op, 1, n, bench_now_ns() - t0);
+
+  delete_rbtree(a);
+  delete_rbtree(b);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = (argc > 1) ? (size_t)atol(argv[1]) : 1000000;
+  const int max_threads = (argc > 2) ? atoi(argv[2]) : 64;
+
+  make_keys(n);
+  for (int op = OP_UNION; op <= OP_DIFFERENCE; op++) run_baseline((op_t)op, n);
+  for (int op = 0; op < OP_COUNT; op++) {
+    run((op_t)op, 0, n);
+    for (int threads = 1; threads <= max_threads; threads *= 2) run((op_t)op, threads, n);
+  }
+
+  free(keys_a);
+  free(keys_b);
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include <rbtree_persistent.h>
+
+#include "bench.h"
+
+// persistent version의 비용: 경로 복사 insert/erase와 find를 rbtree와 비교하고,
+// 읽기용 snapshot을 얻는 비용을 트리 전체 복사(to_array + from_sorted_array)와 비교한다.
+// 사용법: bench-persistent [n]   (기본 1000000)
+
+static void report_ms(const char *impl, const char *op, const size_t n, const uint64_t ns) {
+  printf("{\"impl\":\"%s\",\"op\":\"%s\",\"n\":%zu,\"ms\":%.6f}\n", impl, op, n, ns * 1e-6);
+  fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  key_t *keys = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+  key_t *arr = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+  uint64_t rng = 42;
+  bench_stat s;
+  volatile size_t sink = 0;
+
+  if (keys == NULL || arr == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) keys[i] = (key_t)(bench_rand(&rng) >> 33);
+
+  rbtree *t = new_rbtree();
+  BENCH_LOOP(&s, n, i, rbtree_insert(t, keys[i]));
+  bench_report(&s, "rbtree", "insert", "random", n);
+  BENCH_LOOP(&s, n, i, sink += (rbtree_find(t, keys[i]) != NULL));
+  bench_report(&s, "rbtree", "find", "random", n);
+
+  rbtree_persistent *p = new_rbtree_persistent();
+  BENCH_LOOP(&s, n, i, rbtree_persistent_insert(p, keys[i]));
+  bench_report(&s, "persistent", "insert", "random", n);
+
+  rbtree_version *v = rbtree_persistent_snapshot(p);
+  BENCH_LOOP(&s, n, i, sink += rbtree_version_contains(v, keys[i]));
+  bench_report(&s, "persistent", "find", "random", n);
+
+  // 읽기용 snapshot: 지금은 트리를 통째로 복사해야 하던 것을 version 하나로 대신한다
+  uint64_t t0 = bench_now_ns();
+  rbtree_to_array(t, arr, n);
+  rbtree *copy = rbtree_from_sorted_array(arr, n);
+  report_ms("rbtree", "snapshot_copy", n, bench_now_ns() - t0);
+  delete_rbtree(copy);
+
+  t0 = bench_now_ns();
+  rbtree_version *snap = rbtree_persistent_snapshot(p);
+  report_ms("persistent", "snapshot", n, bench_now_ns() - t0);
+
+  // snapshot이 살아 있는 동안에는 쓰기마다 경로를 복사한다
+  BENCH_LOOP(&s, n, i, rbtree_persistent_erase(p, keys[i]));
+  bench_report(&s, "persistent", "erase", "random", n);
+  BENCH_LOOP(&s, n, i, rbtree_erase(t, rbtree_find(t, keys[i])));
+  bench_report(&s, "rbtree", "erase", "random", n);
+
+  t0 = bench_now_ns();
+  rbtree_version_release(snap);
+  rbtree_version_release(v);
+  report_ms("persistent", "release", n, bench_now_ns() - t0);
+
+  delete_rbtree_persistent(p);
+  delete_rbtree(t);
+  free(arr);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,172 @@
+#include <math.h>
+#include <rbtree.h>
+#include <string.h>
+
+#include "bench.h"
+
+// rbtree.h의 공개 연산별 처리량과 latency 분포를 key 분포/크기별로 측정한다.
+// 사용법: bench-rbtree [max_n] [dist]   (기본 max_n = 1000000, dist 생략 시 전부)
+// 결과는 한 줄에 JSON 객체 하나씩 출력한다.
+
+// RBTREE_BTREE로 빌드하면 같은 측정을 B-tree engine에 대해 한다 (bench-rbtree-btree).
+#ifdef RBTREE_BTREE
+#define IMPL "btree"
+#else
+#define IMPL "rbtree"
+#endif
+
+#define PAGE_KEYS 4096
+#define BATCH_KEYS 1024
+#define SWEEP_WINDOWS 16
+
+typedef enum { DIST_SEQUENTIAL, DIST_RANDOM, DIST_ZIPFIAN, DIST_DUPLICATE, DIST_COUNT } dist_t;
+
+static const char *dist_names[DIST_COUNT] = {"sequential", "random", "zipfian", "duplicate"};
+
+// YCSB 방식의 Zipfian 분포 (theta = 0.99). 순위 0이 가장 자주 나온다.
+static void gen_zipfian(key_t *keys, const size_t n, uint64_t *rng) {
+  const double theta = 0.99;
+  double zetan = 0;
+  for (size_t i = 1; i <= n; i++) zetan += 1.0 / pow((double)i, theta);
+  const double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+  const double alpha = 1.0 / (1.0 - theta);
+  const double eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+
+  for (size_t i = 0; i < n; i++) {
+    const double u = (bench_rand(rng) >> 11) * (1.0 / 9007199254740992.0);
+    const double uz = u * zetan;
+    if (uz < 1.0)                              keys[i] = 0;
+    else if (uz < zeta2)                       keys[i] = 1;
+    else keys[i] = (key_t)(n * pow(eta * u - eta + 1.0, alpha));
+  }
+}
+
+static void gen_keys(key_t *keys, const size_t n, const dist_t dist) {
+  uint64_t rng = 0x9E3779B97F4A7C15ull ^ n;
+
+  switch (dist) {
+    case DIST_SEQUENTIAL:
+      for (size_t i = 0; i < n; i++) keys[i] = (key_t)i;
+      break;
+    case DIST_RANDOM:
+      for (size_t i = 0; i < n; i++) keys[i] = (key_t)(bench_rand(&rng) >> 33);
+      break;
+    case DIST_ZIPFIAN:
+      gen_zipfian(keys, n, &rng);
+      break;
+    case DIST_DUPLICATE:  // 평균 64번씩 반복되는 key
+      for (size_t i = 0; i < n; i++) keys[i] = (key_t)(bench_rand(&rng) % (n / 64 + 1));
+      break;
+    default:
+      break;
+  }
+}
+
+static void bench_one(const size_t n, const dist_t dist) {
+  const char *d = dist_names[dist];
+  key_t *keys = (key_t *)malloc(n * sizeof(key_t));
+  key_t *probes = (key_t *)malloc(n * sizeof(key_t));
+  key_t *page = (key_t *)malloc(PAGE_KEYS * sizeof(key_t));
+  if (keys == NULL || probes == NULL || page == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  gen_keys(keys, n, dist);
+
+  // find는 삽입 순서와 무관하게 트리 안의 key를 무작위로 조회
+  uint64_t rng = 42;
+  for (size_t i = 0; i < n; i++) probes[i] = keys[bench_rand(&rng) % n];
+
+  bench_stat s;
+  rbtree *t = new_rbtree();
+  volatile size_t sink = 0;
+
+  BENCH_LOOP(&s, n, i, rbtree_insert(t, keys[i]));
+  bench_report(&s, IMPL, "insert", d, n);
+
+  BENCH_LOOP(&s, n, i, sink += (rbtree_find(t, probes[i]) != NULL));
+  bench_report(&s, IMPL, "find", d, n);
+
+  BENCH_LOOP(&s, n, i, sink += (size_t)rbtree_min(t));
+  bench_report(&s, IMPL, "min", d, n);
+
+  BENCH_LOOP(&s, n, i, sink += (size_t)rbtree_max(t));
+  bench_report(&s, IMPL, "max", d, n);
+
+  // to_array는 PAGE_KEYS 크기의 page 하나를 내보내는 것을 연산 하나로 센다
+  const size_t pages = (n + PAGE_KEYS - 1) / PAGE_KEYS;
+  rbtree_cursor cursor = {NULL, 0};
+  BENCH_LOOP(&s, pages, i, sink += rbtree_to_array_batch(t, &cursor, page, PAGE_KEYS));
+  bench_report(&s, IMPL, "to_array_page", d, n);
+
+  // erase는 find로 node를 찾는 비용을 포함한다
+  BENCH_LOOP(&s, n, i, rbtree_erase(t, rbtree_find(t, keys[i])));
+  bench_report(&s, IMPL, "erase", d, n);
+
+  delete_rbtree(t);
+
+  // 같은 key를 BATCH_KEYS개씩 batch API로 넣고 지운다. batch 하나를 연산 하나로 세므로
+  // key당 처리량은 ops_per_sec * BATCH_KEYS로 위의 insert/erase와 비교한다.
+  const size_t batches = (n + BATCH_KEYS - 1) / BATCH_KEYS;
+  t = new_rbtree();
+  BENCH_LOOP(&s, batches, i, {
+    const size_t off = i * BATCH_KEYS;
+    rbtree_insert_batch(t, keys + off, (n - off < BATCH_KEYS) ? n - off : BATCH_KEYS);
+  });
+  bench_report(&s, IMPL, "insert_batch", d, n);
+
+  BENCH_LOOP(&s, batches, i, {
+    const size_t off = i * BATCH_KEYS;
+    sink += rbtree_erase_batch(t, keys + off, (n - off < BATCH_KEYS) ? n - off : BATCH_KEYS);
+  });
+  bench_report(&s, IMPL, "erase_batch", d, n);
+
+  delete_rbtree(t);
+
+  // 직전에 넣은/찾은 node를 hint(finger)로 쓴다. sequential 분포에서는 항상 최댓값 뒤에 붙는다.
+  t = new_rbtree();
+  node_t *hint = NULL;
+  BENCH_LOOP(&s, n, i, hint = rbtree_insert_hint(t, hint, keys[i]));
+  bench_report(&s, IMPL, "insert_hint", d, n);
+
+  node_t *finger = NULL;
+  BENCH_LOOP(&s, n, i, {
+    node_t *p = rbtree_find_from(t, finger, keys[i]);
+    if (p != NULL) finger = p;
+  });
+  bench_report(&s, IMPL, "find_from", d, n);
+
+  // TTL sweep: key 공간을 SWEEP_WINDOWS개 구간으로 나눠 작은 쪽부터 구간째로 지운다.
+  // 구간 하나를 연산 하나로 세므로 n개 전체를 지우는 시간은 SWEEP_WINDOWS / ops_per_sec이다.
+  // 경계는 int64_t로 계산해 key_t 범위를 넘지 않게 하고, 마지막 구간은 정확히 hi에서 끝난다.
+  const key_t lo = rbtree_min(t)->key, hi = rbtree_max(t)->key;
+  const int64_t span = (int64_t)hi - lo + 1;
+  BENCH_LOOP(&s, SWEEP_WINDOWS, i, {
+    const key_t from = (key_t)(lo + span * (int64_t)i / SWEEP_WINDOWS);
+    const key_t to = (key_t)(lo + span * (int64_t)(i + 1) / SWEEP_WINDOWS - 1);
+    sink += rbtree_erase_range(t, from, to);
+  });
+  bench_report(&s, IMPL, "erase_range", d, n);
+  if (rbtree_size(t) != 0) {
+    fprintf(stderr, "erase_range sweep left %zu keys\n", rbtree_size(t));
+    exit(EXIT_FAILURE);
+  }
+
+  delete_rbtree(t);
+  free(page);
+  free(probes);
+  free(keys);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t max_n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  const char *only = (argc > 2) ? argv[2] : NULL;
+
+  for (size_t n = 1000; n <= max_n && n <= 100000000; n *= 10) {
+    for (int d = 0; d < DIST_COUNT; d++) {
+      if (only != NULL && strcmp(only, dist_names[d]) != 0) continue;
+      bench_one(n, (dist_t)d);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <rbtree_wal.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// write-ahead log가 insert/erase 한 번에 더하는 비용.
+// 같은 key로 log 없는 rbtree_insert/rbtree_erase와 fsync 간격별 rbtree_wal_insert/erase를 잰다.
+// interval_us 0(연산마다 fsync)은 느리므로 n을 줄여서 잰다. checkpoint와 replay(open) 시간도 함께 출력한다.
+// 사용법: bench-wal [n] [path]   (기본 1000000, /tmp/bench-wal.log)
+
+static void report_ms(const char *impl, const char *op, const size_t n, const uint64_t ns) {
+  printf("{\"impl\":\"%s\",\"op\":\"%s\",\"n\":%zu,\"ms\":%.3f}\n", impl, op, n, ns * 1e-6);
+  fflush(stdout);
+}
+
+static void remove_files(const char *path) {
+  char snap[256];
+
+  snprintf(snap, sizeof(snap), "%s.snap", path);
+  unlink(path);
+  unlink(snap);
+}
+
+static void run_wal(const char *path, const uint64_t interval_us, const key_t *keys, const size_t n) {
+  char impl[64];
+  bench_stat s;
+
+  snprintf(impl, sizeof(impl), "wal_%lluus", (unsigned long long)interval_us);
+  remove_files(path);
+  rbtree_wal *w = rbtree_wal_open(path, interval_us);
+  if (w == NULL) {
+    perror("rbtree_wal_open");
+    exit(EXIT_FAILURE);
+  }
+
+  BENCH_LOOP(&s, n, i, rbtree_wal_insert(w, keys[i]));
+  bench_report(&s, impl, "insert", "random", n);
+  BENCH_LOOP(&s, n, i, rbtree_wal_erase(w, keys[i]));
+  bench_report(&s, impl, "erase", "random", n);
+  if (interval_us == 0) {
+    rbtree_wal_close(w);
+    return;
+  }
+
+  // 다시 채운 트리로 replay와 checkpoint 비용을 잰다
+  for (size_t i = 0; i < n; i++) rbtree_wal_insert(w, keys[i]);
+  rbtree_wal_close(w);
+
+  uint64_t t0 = bench_now_ns();
+  w = rbtree_wal_open(path, interval_us);
+  report_ms(impl, "replay", 3 * n, bench_now_ns() - t0);
+
+  t0 = bench_now_ns();
+  rbtree_wal_checkpoint(w);
+  report_ms(impl, "checkpoint", n, bench_now_ns() - t0);
+  rbtree_wal_close(w);
+
+  t0 = bench_now_ns();
+  w = rbtree_wal_open(path, interval_us);
+  report_ms(impl, "open_snapshot", n, bench_now_ns() - t0);
+  rbtree_wal_close(w);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  const char *path = (argc > 2) ? argv[2] : "/tmp/bench-wal.log";
+  key_t *keys = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+  uint64_t rng = 42;
+  bench_stat s;
+
+  if (keys == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) keys[i] = (key_t)(bench_rand(&rng) >> 33);
+
+  rbtree *t = new_rbtree();
+  BENCH_LOOP(&s, n, i, rbtree_insert(t, keys[i]));
+  bench_report(&s, "rbtree", "insert", "random", n);
+  BENCH_LOOP(&s, n, i, rbtree_erase(t, rbtree_find(t, keys[i])));
+  bench_report(&s, "rbtree", "erase", "random", n);
+  delete_rbtree(t);
+
+  const uint64_t intervals[] = {100000, 10000, 1000};
+  for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++) run_wal(path, intervals[i], keys, n);
+  run_wal(path, 0, keys, (n < 1000) ? n : 1000);
+
+  remove_files(path);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,99 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 벤치마크 공통 도구: 시간 측정, latency 표본, JSON lines 형식의 결과 출력
+
+#define BENCH_MAX_SAMPLES 1000000
+
+static inline uint64_t bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 연산 n번 중 일정 간격(stride)마다 한 번씩 개별 latency를 기록한다.
+typedef struct {
+  uint64_t *ns;
+  size_t count, stride;
+  uint64_t start, total_ns;
+  size_t ops;
+} bench_stat;
+
+static inline void bench_begin(bench_stat *s, const size_t ops) {
+  s->stride = ops / BENCH_MAX_SAMPLES + 1;
+  s->ns = (uint64_t *)malloc((ops / s->stride + 1) * sizeof(uint64_t));
+  if (s->ns == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  s->count = 0;
+  s->ops = ops;
+  s->start = bench_now_ns();
+}
+
+static inline void bench_end(bench_stat *s) {
+  s->total_ns = bench_now_ns() - s->start;
+}
+
+// i번째 연산을 표본으로 기록할지 여부
+#define BENCH_SAMPLED(s, i) ((i) % (s)->stride == 0)
+#define BENCH_RECORD(s, t0) ((s)->ns[(s)->count++] = bench_now_ns() - (t0))
+
+// body를 ops번 실행하면서 전체 시간과 표본 latency를 잰다. i는 0부터의 반복 번호.
+#define BENCH_LOOP(s, ops, i, body)                 \
+  do {                                              \
+    bench_begin((s), (ops));                        \
+    for (size_t i = 0; i < (ops); i++) {            \
+      if (BENCH_SAMPLED((s), i)) {                  \
+        const uint64_t bench_t0_ = bench_now_ns();  \
+        body;                                       \
+        BENCH_RECORD((s), bench_t0_);               \
+      } else {                                      \
+        body;                                       \
+      }                                             \
+    }                                               \
+    bench_end(s);                                   \
+  } while (0)
+
+// 재현 가능한 key 생성을 위한 xorshift64*
+static inline uint64_t bench_rand(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1Dull;
+}
+
+static int bench_cmp_u64(const void *a, const void *b) {
+  const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static inline uint64_t bench_percentile(const bench_stat *s, const double q) {
+  if (s->count == 0) return 0;
+  size_t i = (size_t)(q * (s->count - 1) + 0.5);
+  return s->ns[i];
+}
+
+static inline void bench_report(bench_stat *s, const char *impl, const char *op,
+                                const char *dist, const size_t n) {
+  qsort(s->ns, s->count, sizeof(uint64_t), bench_cmp_u64);
+  const double sec = s->total_ns * 1e-9;
+  printf("{\"impl\":\"%s\",\"op\":\"%s\",\"dist\":\"%s\",\"n\":%zu,\"ops\":%zu,"
+         "\"ops_per_sec\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu}\n",
+         impl, op, dist, n, s->ops, sec > 0 ? s->ops / sec : 0.0,
+         (unsigned long long)bench_percentile(s, 0.50),
+         (unsigned long long)bench_percentile(s, 0.99),
+         (unsigned long long)bench_percentile(s, 0.999));
+  fflush(stdout);
+  free(s->ns);
+  s->ns = NULL;
+}
+
+#endif  // _BENCH_H_
@@ -1,25 +1,38 @@
 #include "rbtree.h"
 #include <stdio.h>
 
+// n을 루트로 하는 서브트리를 전위 순회로 출력한다. 재귀 없이 parent 포인터를 따라 올라간다.
 void print_tree_structure(rbtree *t, node_t *n, int depth) {
-    if (n == t->nil) {
-        return;
-    }
+    node_t *top = n;
 
-    for (int i = 0; i < depth; i++) {
-        printf("  ");
-    }
+    while (n != t->nil) {
+        for (int i = 0; i < depth; i++) {
+            printf("  ");
+        }
 
-    printf("Node key: %d, Color: %s, ", n->key, n->color == RBTREE_RED ? "RED" : "BLACK");
-    if (n->parent != t->nil) {
-        printf("Parent key: %d", n->parent->key);
-    } else {
-        printf("Parent: NULL");
-    }
-    printf("\n");
+        printf("Node key: %d, Color: %s, ", n->key, n->color == RBTREE_RED ? "RED" : "BLACK");
+        if (n->parent != t->nil) {
+            printf("Parent key: %d", n->parent->key);
+        } else {
+            printf("Parent: NULL");
+        }
+        printf("\n");
 
-    print_tree_structure(t, n->left, depth+1);
-    print_tree_structure(t, n->right, depth+1);
+        if (n->left != t->nil || n->right != t->nil) {
+            n = (n->left != t->nil) ? n->left : n->right;
+            depth++;
+            continue;
+        }
+        // 왼쪽 자식에서 올라왔고 오른쪽 자식이 있는 조상까지 올라가서 그 오른쪽으로
+        while (n != top && (n == n->parent->right || n->parent->right == t->nil)) {
+            n = n->parent;
+            depth--;
+        }
+        if (n == top) {
+            break;
+        }
+        n = n->parent->right;
+    }
 }
 
 int main() {
@@ -2,8 +2,131 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-rbtree *new_rbtree(void) {
+#define RBTREE_SLAB_MIN 64                               // 첫 slab의 node 수
+#define RBTREE_SLAB_MAX 65536                            // slab 하나의 최대 node 수
+
+// RBTREE_STATS 없이 빌드하면 아무 코드도 남지 않는다
+#ifdef RBTREE_STATS
+#define RBTREE_STAT_ADD(t, field, n) ((t)->stats.field += (n))
+#define RBTREE_STAT_DEPTH(t, d) \
+  ((t)->stats.insert_depth[(d) < RBTREE_STATS_DEPTH ? (d) : RBTREE_STATS_DEPTH - 1]++)
+#else
+#define RBTREE_STAT_ADD(t, field, n) ((void)0)
+#define RBTREE_STAT_DEPTH(t, d) ((void)(d))
+#endif
+
+// 고정 크기 node 묶음. 트리가 소유하며 delete_rbtree에서 한 번에 반환한다.
+struct rbtree_slab {
+  rbtree_slab *next;
+  size_t cap;
+  node_t nodes[];
+};
+
+static rbtree_slab *rbtree_slab_new(size_t cap)
+{
+  // 0으로 초기화해 두면 아직 쓰이지 않은 node의 링크는 항상 NULL이다 (rbtree_concurrent 참고)
+  rbtree_slab *slab = (rbtree_slab *)calloc(1, sizeof(rbtree_slab) + cap * sizeof(node_t));
+
+  if (slab == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  slab->cap = cap;
+  return slab;
+}
+
+static void rbtree_slab_push(rbtree *t, size_t cap)
+{
+  rbtree_slab *slab = rbtree_slab_new(cap);
+
+  RBTREE_STAT_ADD(t, slab_allocs, 1);
+  slab->next = t->slabs;
+  t->slabs = slab;
+  t->slab_used = 0;
+}
+
+static node_t *rbtree_node_alloc(rbtree *t)
+{
+  node_t *n = t->free_list;
+
+  RBTREE_STAT_ADD(t, node_allocs, 1);
+  if (n != NULL)                                         // 반환된 node가 있으면 먼저 재사용
+  {
+    t->free_list = n->parent;
+    return n;
+  }
+
+  n = t->free_trees;
+  if (n != NULL)                                         // 떼어낸 서브트리는 루트를 꺼내고 두 자식을 다시 쌓는다
+  {
+    t->free_trees = n->parent;
+    if (n->left != t->nil)
+    {
+      n->left->parent = t->free_trees;
+      t->free_trees = n->left;
+    }
+    if (n->right != t->nil)
+    {
+      n->right->parent = t->free_trees;
+      t->free_trees = n->right;
+    }
+    return n;
+  }
+
+  if (t->slabs == NULL || t->slab_used == t->slabs->cap)
+  {
+    size_t cap = (t->slabs == NULL) ? RBTREE_SLAB_MIN : t->slabs->cap * 2;
+    if (cap > RBTREE_SLAB_MAX) cap = RBTREE_SLAB_MAX;
+    if (cap < RBTREE_SLAB_MIN) cap = RBTREE_SLAB_MIN;
+    rbtree_slab_push(t, cap);
+  }
+
+  return &t->slabs->nodes[t->slab_used++];
+}
+
+static void rbtree_node_free(rbtree *t, node_t *n)
+{
+  RBTREE_STAT_ADD(t, node_frees, 1);
+  n->parent = t->free_list;                              // free list는 parent 포인터로 연결
+  t->free_list = n;
+}
+
+node_t *rbtree_reserve_nodes(rbtree *t, const size_t n) {
+  // 연속된 n개의 node를 전용 slab으로 할당한다.
+  // 현재 slab 뒤에 끼워 넣어 rbtree_node_alloc의 할당 위치는 그대로 둔다.
+  rbtree_slab *slab = rbtree_slab_new(n);
+
+  RBTREE_STAT_ADD(t, slab_allocs, 1);
+  RBTREE_STAT_ADD(t, node_allocs, n);
+  if (t->slabs == NULL)
+  {
+    slab->next = NULL;
+    t->slabs = slab;
+    t->slab_used = n;
+  }
+  else
+  {
+    slab->next = t->slabs->next;
+    t->slabs->next = slab;
+  }
+  return slab->nodes;
+}
+
+void rbtree_release_nodes(rbtree *t, node_t *head, node_t *tail) {
+  // parent 포인터로 연결된 head..tail 목록을 한 번에 free list에 붙인다
+  if (head == NULL) return;
+#ifdef RBTREE_STATS
+  for (node_t *p = head; p != tail; p = p->parent) t->stats.node_frees++;
+  t->stats.node_frees++;
+#endif
+  tail->parent = t->free_list;
+  t->free_list = head;
+}
+
+rbtree *new_rbtree_with_capacity(const size_t capacity) {
 
   rbtree *p = (rbtree *)calloc(1, sizeof(rbtree));       // rbtree를 위한 메모리 할당
   
@@ -31,28 +154,74 @@ rbtree *new_rbtree(void) {
   // 루트 노드 초기화
   p->root = NIL;
 
+  // capacity가 주어지면 node들을 하나의 slab으로 미리 할당
+  if (capacity > 0) rbtree_slab_push(p, capacity);
+
   return p;
 }
 
-void rbtree_postorder_node_delete(rbtree *t, node_t *ptr)
-{
-  if (ptr == t->nil) return;
-  rbtree_postorder_node_delete(t, ptr->left);
-  rbtree_postorder_node_delete(t, ptr->right);
+rbtree *new_rbtree(void) {
+  return new_rbtree_with_capacity(0);
+}
+
+rbtree *new_rbtree_counted(void) {
+  rbtree *t = new_rbtree_with_capacity(0);
 
-  free(ptr);
+  t->counted = 1;
+  return t;
 }
 
 void delete_rbtree(rbtree *t) {
   if (t == NULL) return;
 
-  // TODO: reclaim the tree nodes's memory
-  rbtree_postorder_node_delete(t, t->root);
+  // node는 모두 slab 안에 있으므로 트리를 순회하지 않고 slab만 반환
+  rbtree_slab *slab = t->slabs;
+  while (slab != NULL)
+  {
+    rbtree_slab *next = slab->next;
+    free(slab);
+    slab = next;
+  }
 
   free(t->nil);
   free(t);
 }
 
+// arr[lo, hi) 구간의 중간 값을 루트로 하는 균형 서브트리를 만든다.
+// node는 slab 안의 in-order 위치에 그대로 놓이므로 메모리상으로도 정렬되어 있다.
+node_t *rbtree_build_sorted(rbtree *t, node_t *nodes, const key_t *arr, size_t lo, size_t hi,
+                            node_t *parent, int depth, int red_depth) {
+  if (lo == hi) return t->nil;
+
+  size_t mid = lo + (hi - lo) / 2;
+  node_t *n = &nodes[mid];
+
+  n->key = arr[mid];
+  n->parent = parent;
+  n->size = hi - lo;
+  // 중간 값 분할은 마지막 level을 제외한 모든 level을 가득 채우므로
+  // 가장 깊은 level만 red로 칠하면 모든 경로의 black 높이가 같아진다.
+  n->color = (depth == red_depth) ? RBTREE_RED : RBTREE_BLACK;
+  n->left = rbtree_build_sorted(t, nodes, arr, lo, mid, n, depth + 1, red_depth);
+  n->right = rbtree_build_sorted(t, nodes, arr, mid + 1, hi, n, depth + 1, red_depth);
+
+  return n;
+}
+
+rbtree *rbtree_from_sorted_array(const key_t *arr, const size_t n) {
+  rbtree *t = new_rbtree();
+
+  if (n == 0) return t;
+
+  int height = 0;                                        // floor(log2(n)): 가장 깊은 level
+  while (((size_t)2 << height) <= n) height++;
+
+  node_t *nodes = rbtree_reserve_nodes(t, n);            // 모든 node를 하나의 연속된 block에
+  t->root = rbtree_build_sorted(t, nodes, arr, 0, n, t->nil, 0, height > 0 ? height : -1);
+
+  return t;
+}
+
 void rbtree_left_rotate(rbtree *t, node_t *x)
 {
     node_t *y;
@@ -77,6 +246,11 @@ void rbtree_left_rotate(rbtree *t, node_t *x)
     }
     y -> left = x;
     x -> parent = y;
+    // x는 y 서브트리를 내주고 y의 왼쪽 서브트리를 받는다 (x의 multiplicity가 1이 아니어도 맞다)
+    size_t x_size = x -> size;
+    x -> size = x_size - y -> size + x -> right -> size;
+    y -> size = x_size;
+    RBTREE_STAT_ADD(t, rotations, 1);
     return;
 }
 
@@ -104,14 +278,20 @@ void rbtree_right_rotate(rbtree *t, node_t *x)
     }
     y -> right = x;
     x -> parent = y;
+    size_t x_size = x -> size;
+    x -> size = x_size - y -> size + x -> left -> size;
+    y -> size = x_size;
+    RBTREE_STAT_ADD(t, rotations, 1);
     return;
 }
 
-void rbtree_insert_fixup(rbtree *t, node_t *z){
+// 루트가 red가 되어 다시 black으로 칠했으면, 즉 트리의 black 높이가 1 늘었으면 1을 반환한다
+int rbtree_insert_fixup(rbtree *t, node_t *z){
     node_t *uncle;
     // while ((z != t->root) && (z->color != RBTREE_BLACK) && (z->parent->color == RBTREE_RED))
     while (z->parent->color == RBTREE_RED)
     {
+        RBTREE_STAT_ADD(t, insert_fixup_loops, 1);
         if (z -> parent == z -> parent -> parent -> left)
         {
             uncle = z -> parent -> parent -> right;
@@ -121,6 +301,7 @@ void rbtree_insert_fixup(rbtree *t, node_t *z){
                 z -> parent -> color = RBTREE_BLACK;
                 uncle -> color = RBTREE_BLACK;
                 z -> parent -> parent -> color = RBTREE_RED;
+                RBTREE_STAT_ADD(t, recolors, 3);
                 z = z -> parent -> parent;
             }
             //경우2
@@ -133,6 +314,7 @@ void rbtree_insert_fixup(rbtree *t, node_t *z){
                 //경우3
                 z -> parent -> color = RBTREE_BLACK;
                 z -> parent -> parent -> color = RBTREE_RED;
+                RBTREE_STAT_ADD(t, recolors, 2);
                 rbtree_right_rotate(t, z -> parent -> parent);
             }
         }
@@ -146,6 +328,7 @@ void rbtree_insert_fixup(rbtree *t, node_t *z){
                 z -> parent -> color = RBTREE_BLACK;
                 uncle -> color = RBTREE_BLACK;
                 z -> parent -> parent -> color = RBTREE_RED;
+                RBTREE_STAT_ADD(t, recolors, 3);
                 z = z -> parent -> parent;
             }
             //경우2
@@ -160,48 +343,81 @@ void rbtree_insert_fixup(rbtree *t, node_t *z){
                 {
                     z -> parent -> color = RBTREE_BLACK;
                     z -> parent -> parent->color = RBTREE_RED;
+                    RBTREE_STAT_ADD(t, recolors, 2);
                     rbtree_left_rotate(t, z -> parent -> parent);
                 }
             }
         }
     }
+    const int grew = t -> root -> color == RBTREE_RED;
+    RBTREE_STAT_ADD(t, recolors, grew);
     t -> root -> color = RBTREE_BLACK;
+    return grew;
 }
 
-node_t *rbtree_insert(rbtree *t, const key_t key) {
-  // TODO: implement insert
-
+// 초기화된 z를 from 서브트리 안의 자리에 연결한다. from은 z의 자리를 포함하는 서브트리의 루트.
+static void rbtree_insert_node(rbtree *t, node_t *z, node_t *from)
+{
   node_t *parent = t->nil;
-  node_t *ptr = t->root;
-  node_t *z = (node_t *)calloc(1, sizeof(node_t));      // node_t 위한 메모리 할당
-  
-  if (z == NULL) {                                      // node_t를 위한 메모리 할당 실패 시 예외 처리
-        fprintf(stderr, "Memory allocation failed\n");  // stderr: 표준 에러 출력 스트림
-        exit(EXIT_FAILURE);   
-  }
+  node_t *ptr = from;
+  size_t depth = 0;
 
-  z->key = key;                                         // 새롭게 삽입할 노드의 key 설정
+  if (from != t->nil)                                   // from 위쪽 조상들의 서브트리 크기 갱신
+  {
+    parent = from->parent;
+    for (node_t *p = parent; p != t->nil; p = p->parent) p->size++;
+  }
 
   while (ptr != t->nil)
   {
     //if (ptr == NULL) break;
 
     parent = ptr;                                       // 반복문 첫 번째 시행 시, z의 부모 노드는 잠정적으로 루트 노드인 x
+    ptr->size++;                                        // 경로 위의 서브트리 크기 갱신
+    depth++;
     if (z->key < ptr->key)  ptr = ptr->left;            // pointer를 x의 left로 변경
     else                    ptr = ptr->right;           // pointer를 x의 right로 변경
   }
+  RBTREE_STAT_DEPTH(t, depth);
 
   z->parent = parent;
   if (parent == t->nil)           t->root = z;
   else if (z->key < parent->key)  parent->left = z;
   else                            parent->right = z;
 
+  rbtree_insert_fixup(t, z);
+}
+
+static void rbtree_node_init(rbtree *t, node_t *z, const key_t key)
+{
+  z->key = key;                                         // 새롭게 삽입할 노드의 key 설정
+  // 트리에 연결되기 전에 모든 필드를 채워 두어, 연결되는 순간부터 z를 따라가도 안전하게 한다
   z->left = t->nil;
   z->right = t->nil;
   z->color = RBTREE_RED;
+  z->size = 1;
+}
+
+// counted 트리에 이미 있는 key: 새 node 없이 p부터 루트까지 크기만 하나씩 올린다
+static node_t *rbtree_count_add(const rbtree *t, node_t *p)
+{
+  for (node_t *q = p; q != t->nil; q = q->parent) q->size++;
+  return p;
+}
+
+node_t *rbtree_insert(rbtree *t, const key_t key) {
+  // TODO: implement insert
+  if (t->counted)
+  {
+    node_t *p = rbtree_find(t, key);
+    if (p != NULL) return rbtree_count_add(t, p);
+  }
+
+  node_t *z = rbtree_node_alloc(t);                     // 트리의 slab에서 node 할당
+
+  rbtree_node_init(t, z, key);
+  rbtree_insert_node(t, z, t->root);
 
-  rbtree_insert_fixup(t, z);
-  
   return z;
 }
 
@@ -219,6 +435,55 @@ node_t *rbtree_find(const rbtree *t, const key_t key) {
   return NULL;
 }
 
+#define RBTREE_BATCH_WIDTH 16                            // 동시에 진행하는 탐색 경로 수
+
+size_t rbtree_find_batch(const rbtree *t, const key_t *keys, const size_t n, node_t **out) {
+  // 여러 key의 탐색을 한 level씩 번갈아 진행하고, 다음에 방문할 node를 미리 prefetch 해서
+  // 한 key의 cache miss를 기다리는 동안 다른 key들의 메모리 접근이 겹치도록 한다.
+  node_t *cur[RBTREE_BATCH_WIDTH];
+  size_t idx[RBTREE_BATCH_WIDTH];
+  size_t next = 0, found = 0;
+  int live = 0;
+
+  for (int j = 0; j < RBTREE_BATCH_WIDTH; j++)
+  {
+    if (next < n) { cur[j] = t->root; idx[j] = next++; live++; }
+    else          cur[j] = NULL;                         // 비어 있는 경로
+  }
+
+  while (live > 0)
+  {
+    for (int j = 0; j < RBTREE_BATCH_WIDTH; j++)
+    {
+      node_t *ptr = cur[j];
+      if (ptr == NULL) continue;
+
+      const key_t key = keys[idx[j]];
+      node_t *result = NULL;
+      int done = 0;
+
+      if (ptr == t->nil)          done = 1;
+      else if (ptr->key == key)   { result = ptr; done = 1; }
+      else
+      {
+        ptr = (key < ptr->key) ? ptr->left : ptr->right;
+        __builtin_prefetch(ptr);
+        cur[j] = ptr;
+      }
+
+      if (done)                                          // 끝난 경로에는 다음 key를 채운다
+      {
+        out[idx[j]] = result;
+        found += (result != NULL);
+        if (next < n) { cur[j] = t->root; idx[j] = next++; }
+        else          { cur[j] = NULL; live--; }
+      }
+    }
+  }
+
+  return found;
+}
+
   node_t *rbtree_min(const rbtree *t) {
     // TODO: implement find
     node_t *ptr = t->root;
@@ -260,7 +525,7 @@ node_t *subtree_min(const rbtree *t, node_t *sub_root) {
 
 node_t *subtree_max(const rbtree *t, node_t *sub_root) {
   // TODO: implement find
-  node_t *ptr = t->root;
+  node_t *ptr = sub_root;
   
   if (ptr == t->nil) return ptr;
   while (ptr->right != t->nil) ptr = ptr->right;
@@ -272,6 +537,7 @@ void rb_delete_fixup(rbtree *t, node_t *x){
     node_t *w;
     while ((x != t -> root) && (x -> color == RBTREE_BLACK))
     {
+        RBTREE_STAT_ADD(t, erase_fixup_loops, 1);
         if (x == x -> parent -> left)
         {
             w = x -> parent -> right;
@@ -279,12 +545,14 @@ void rb_delete_fixup(rbtree *t, node_t *x){
             {
                 w -> color = RBTREE_BLACK;
                 x -> parent -> color = RBTREE_RED;
+                RBTREE_STAT_ADD(t, recolors, 2);
                 rbtree_left_rotate(t, x -> parent);
                 w = x -> parent -> right;
             }
             if (w -> left -> color == RBTREE_BLACK && w -> right -> color == RBTREE_BLACK)
             {
                 w -> color = RBTREE_RED;
+                RBTREE_STAT_ADD(t, recolors, 1);
                 x = x -> parent;
             }
             else
@@ -293,12 +561,14 @@ void rb_delete_fixup(rbtree *t, node_t *x){
                 {
                     w -> left -> color = RBTREE_BLACK;
                     w -> color = RBTREE_RED;
+                    RBTREE_STAT_ADD(t, recolors, 2);
                     rbtree_right_rotate(t, w);
                     w = x -> parent -> right;
                 }
                 w -> color = x -> parent -> color;
                 x -> parent -> color = RBTREE_BLACK;
                 w -> right -> color = RBTREE_BLACK;
+                RBTREE_STAT_ADD(t, recolors, 3);
                 rbtree_left_rotate(t, x -> parent);
                 x = t->root;
             }
@@ -310,12 +580,14 @@ void rb_delete_fixup(rbtree *t, node_t *x){
             {
                 w -> color = RBTREE_BLACK;
                 x -> parent->color = RBTREE_RED;
+                RBTREE_STAT_ADD(t, recolors, 2);
                 rbtree_right_rotate(t, x -> parent);
                 w = x -> parent->left;
             }
             if (w -> right -> color == RBTREE_BLACK && w -> left -> color == RBTREE_BLACK)
             {
                 w -> color = RBTREE_RED;
+                RBTREE_STAT_ADD(t, recolors, 1);
                 x = x -> parent;
             }
             else
@@ -324,17 +596,22 @@ void rb_delete_fixup(rbtree *t, node_t *x){
                 {
                     w -> right -> color = RBTREE_BLACK;
                     w -> color = RBTREE_RED;
+                    RBTREE_STAT_ADD(t, recolors, 2);
                     rbtree_left_rotate(t, w);
                     w = x -> parent -> left;
                 }
                 w -> color = x -> parent -> color;
                 x -> parent -> color = RBTREE_BLACK;
                 w -> left -> color = RBTREE_BLACK;
+                RBTREE_STAT_ADD(t, recolors, 3);
                 rbtree_right_rotate(t, x -> parent);
                 x = t -> root;
             }
         }
     }
+#ifdef RBTREE_STATS
+    if (x -> color == RBTREE_RED) t -> stats.recolors++;
+#endif
     x -> color = RBTREE_BLACK;
 }
 
@@ -342,6 +619,24 @@ int rbtree_erase(rbtree *t, node_t *z){
     node_t *y = z;
     color_t y_orginal_color = y->color;
     node_t *x;
+    node_t *p;
+    // counted 트리에서 z에 key가 더 남아 있으면 node는 그대로 두고 개수만 내린다
+    if (t -> counted && rbtree_count(t, z) > 1)
+    {
+        for (p = z; p != t -> nil; p = p -> parent) p -> size--;
+        return 0;
+    }
+    // 실제로 자리가 빠지는 위치(z 또는 z의 successor)의 부모부터 루트까지 크기 감소.
+    // successor가 z 자리로 올라가면 그 사이의 node들은 successor의 multiplicity만큼 줄어든다.
+    if (z -> left == t -> nil || z -> right == t -> nil) p = z -> parent;
+    else
+    {
+        node_t *s = subtree_min(t, z -> right);
+        const size_t moved = s -> size - s -> right -> size;
+        for (p = s -> parent; p != z; p = p -> parent) p -> size -= moved;
+    }
+    for (; p != t -> nil; p = p -> parent) p -> size--;
+
     if (z -> left == t -> nil)
     {
         x = z -> right;
@@ -371,36 +666,674 @@ int rbtree_erase(rbtree *t, node_t *z){
         y -> left = z -> left;
         y -> left -> parent = y;
         y -> color = z -> color;
+        y -> size = z -> size;
     }
     if (y_orginal_color == RBTREE_BLACK)
     {
         rb_delete_fixup(t, x);
     }
-    free(z);
+    rbtree_node_free(t, z);
     return 0;
 }
 
 
-int rbtree_inorder_tree_walk(const rbtree *t, node_t *ptr, key_t *arr, int depth)
+// parent 포인터를 따라 in-order 다음 node를 찾는다. 마지막 node면 t->nil.
+static node_t *rbtree_successor(const rbtree *t, node_t *x)
 {
-  if (ptr == t->nil)
+  if (x->right != t->nil) return subtree_min(t, x->right);
+
+  node_t *y = x->parent;
+  while (y != t->nil && x == y->right)
+  {
+    x = y;
+    y = y->parent;
+  }
+  return y;
+}
+
+// rbtree_successor의 대칭. 첫 node면 t->nil.
+static node_t *rbtree_predecessor(const rbtree *t, node_t *x)
+{
+  if (x->left != t->nil) return subtree_max(t, x->left);
+
+  node_t *y = x->parent;
+  while (y != t->nil && x == y->left)
+  {
+    x = y;
+    y = y->parent;
+  }
+  return y;
+}
+
+node_t *rbtree_next(const rbtree *t, const node_t *p) {
+  node_t *q = rbtree_successor(t, (node_t *)p);
+  return (q == t->nil) ? NULL : q;
+}
+
+node_t *rbtree_prev(const rbtree *t, const node_t *p) {
+  node_t *q = rbtree_predecessor(t, (node_t *)p);
+  return (q == t->nil) ? NULL : q;
+}
+
+node_t *rbtree_lower_bound(const rbtree *t, const key_t key) {
+  // key 이상인 첫 node, 없으면 NULL
+  node_t *ptr = t->root;
+  node_t *found = NULL;
+
+  while (ptr != t->nil)
   {
-    return depth;
+    if (ptr->key < key) ptr = ptr->right;
+    else                { found = ptr; ptr = ptr->left; }
   }
-  depth = rbtree_inorder_tree_walk(t, ptr->left, arr, depth);
-  arr[depth] = ptr->key;
-  depth += 1;
-  depth = rbtree_inorder_tree_walk(t, ptr->right, arr, depth);
 
-  return depth;
+  return found;
+}
+
+node_t *rbtree_upper_bound(const rbtree *t, const key_t key) {
+  // key 초과인 첫 node, 없으면 NULL
+  node_t *ptr = t->root;
+  node_t *found = NULL;
+
+  while (ptr != t->nil)
+  {
+    if (ptr->key <= key) ptr = ptr->right;
+    else                 { found = ptr; ptr = ptr->left; }
+  }
+
+  return found;
+}
+
+size_t rbtree_range_foreach(const rbtree *t, const key_t lo, const key_t hi,
+                            rbtree_visit_fn fn, void *arg) {
+  // [lo, hi] 구간의 node를 key 순서대로 방문. fn이 0이 아닌 값을 반환하면 중단
+  size_t count = 0;
+
+  for (node_t *p = rbtree_lower_bound(t, lo); p != NULL && p->key <= hi; p = rbtree_next(t, p))
+  {
+    count++;
+    if (fn(p, arg) != 0) break;
+  }
+
+  return count;
+}
+
+size_t rbtree_range(const rbtree *t, const key_t lo, const key_t hi, key_t *arr, const size_t n) {
+  // [lo, hi] 구간의 key를 최대 n개까지 arr에 기록하고 기록한 개수를 반환
+  size_t i = 0;
+
+  for (node_t *p = rbtree_lower_bound(t, lo); i < n && p != NULL && p->key <= hi; p = rbtree_next(t, p))
+  {
+    for (size_t c = rbtree_count(t, p); c > 0 && i < n; c--) arr[i++] = p->key;
+  }
+
+  return i;
+}
+
+// cursor부터 in-order로 최대 n개를 기록하고 cursor를 다음에 기록할 자리로 옮긴다.
+// page가 node 중간에서 차면 cursor는 그 node에 남고 offset만 늘어난다.
+static size_t rbtree_emit(const rbtree *t, rbtree_cursor *cursor, key_t *arr, const size_t n)
+{
+  node_t *ptr = cursor->node;
+  size_t done = cursor->offset;
+  size_t i = 0;
+
+  // 재귀나 스택 없이 parent 포인터로 순회하며 정확히 n개까지만 기록
+  while (i < n && ptr != t->nil)
+  {
+    const size_t c = rbtree_count(t, ptr);
+    size_t take = c - done;
+    if (take > n - i) take = n - i;
+    for (done += take; take > 0; take--) arr[i++] = ptr->key;
+    if (done < c) break;
+    ptr = rbtree_successor(t, ptr);
+    done = 0;
+  }
+
+  cursor->node = ptr;
+  cursor->offset = done;
+  return i;
+}
+
+size_t rbtree_to_array_batch(const rbtree *t, rbtree_cursor *cursor, key_t *arr, const size_t n) {
+  // cursor->node가 NULL이면 최솟값부터 시작, t->nil이면 이미 끝까지 내보낸 상태
+  if (cursor->node == NULL)
+  {
+    cursor->node = subtree_min(t, t->root);
+    cursor->offset = 0;
+  }
+  return rbtree_emit(t, cursor, arr, n);
 }
 
 int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
-  // TODO: implement to_array
+  rbtree_cursor cursor = {subtree_min(t, t->root), 0};
+
+  return (int)rbtree_emit(t, &cursor, arr, n);
+}
+
+size_t rbtree_size(const rbtree *t) {
+  return t->root->size;                                  // nil의 size는 0
+}
+
+node_t *rbtree_select(const rbtree *t, const size_t k) {
+  // 0부터 센 k번째로 작은 key를 가진 node
+  node_t *ptr = t->root;
+  size_t rank = k;
 
-  if (t->root == t->nil) return -1;
+  if (k >= t->root->size) return NULL;
 
-  rbtree_inorder_tree_walk(t, t->root, arr, 0);
+  while (ptr != t->nil)
+  {
+    size_t left_size = ptr->left->size;
+    size_t upto = ptr->size - ptr->right->size;          // 왼쪽 서브트리와 이 node의 key 수
+    if (rank < left_size)       ptr = ptr->left;
+    else if (rank >= upto)      { rank -= upto; ptr = ptr->right; }
+    else                        return ptr;
+  }
 
+  return NULL;
+}
+
+size_t rbtree_rank(const rbtree *t, const key_t key) {
+  // key보다 작은 key의 개수
+  node_t *ptr = t->root;
+  size_t rank = 0;
+
+  while (ptr != t->nil)
+  {
+    if (ptr->key < key) { rank += ptr->size - ptr->right->size; ptr = ptr->right; }
+    else                ptr = ptr->left;
+  }
+
+  return rank;
+}
+
+size_t rbtree_count(const rbtree *t, const node_t *p) {
+  (void)t;
+  return p->size - p->left->size - p->right->size;
+}
+
+int rbtree_stats(const rbtree *t, rbtree_stats_t *out) {
+#ifdef RBTREE_STATS
+  *out = t->stats;
+  return 1;
+#else
+  (void)t;
+  memset(out, 0, sizeof(*out));
   return 0;
+#endif
+}
+
+void rbtree_stats_reset(rbtree *t) {
+#ifdef RBTREE_STATS
+  memset(&t->stats, 0, sizeof(t->stats));
+#else
+  (void)t;
+#endif
+}
+
+// 서브트리 r의 node 수. counted 트리에서는 size가 node 수가 아니므로 전위 순회로 센다.
+static size_t rbtree_subtree_nodes(const rbtree *t, const node_t *r)
+{
+  size_t count = 0;
+  const node_t *p = r;
+
+  if (!t->counted) return r->size;
+  while (p != t->nil)
+  {
+    count++;
+    if (p->left != t->nil)   { p = p->left; continue; }
+    if (p->right != t->nil)  { p = p->right; continue; }
+    while (p != r && (p == p->parent->right || p->parent->right == t->nil)) p = p->parent;
+    if (p == r) break;
+    p = p->parent->right;
+  }
+  return count;
+}
+
+
+void rbtree_memory_usage(const rbtree *t, rbtree_memory_t *out) {
+  // slab은 목록만 훑고, 흩어진 정도는 in-order로 이웃한 node가 메모리에서도 바로 옆인지 세어 추정한다
+  size_t slots = 0, breaks = 0;
+
+  memset(out, 0, sizeof(*out));
+  out->bytes = sizeof(rbtree) + sizeof(node_t);          // 트리 구조체와 nil
+  for (const rbtree_slab *slab = t->slabs; slab != NULL; slab = slab->next)
+  {
+    out->slabs++;
+    slots += slab->cap;
+    out->bytes += sizeof(rbtree_slab) + slab->cap * sizeof(node_t);
+  }
+
+  for (node_t *p = subtree_min(t, t->root); p != t->nil;)
+  {
+    node_t *next = rbtree_successor(t, p);
+    out->nodes++;
+    if (next != t->nil && next != p + 1) breaks++;
+    p = next;
+  }
+  out->free_nodes = slots - out->nodes;
+  out->fragmentation = (out->nodes > 1) ? (double)breaks / (double)(out->nodes - 1) : 0.0;
+}
+
+// compact 도중 원래 node의 size 자리에는 새 slab에서의 index가 들어 있다
+static node_t *rbtree_relocated(const rbtree *t, node_t *nodes, const node_t *old)
+{
+  return (old == t->nil) ? t->nil : &nodes[old->size];
+}
+
+void rbtree_compact(rbtree *t) {
+  // 트리의 node를 in-order 순서대로 딱 맞는 slab 하나에 옮기고 이전 slab은 모두 반환한다.
+  // 옮기는 동안 추가 메모리는 새 slab뿐이며, 원래 node의 필드를 임시 저장소로 쓴다.
+  const size_t n = rbtree_subtree_nodes(t, t->root);
+  rbtree_slab *compacted = NULL;
+
+  if (n > 0)
+  {
+    compacted = rbtree_slab_new(n);
+    RBTREE_STAT_ADD(t, slab_allocs, 1);
+    node_t *nodes = compacted->nodes;
+    size_t i = 0;
+
+    // 1. key, color, size를 순서대로 복사하고 parent 자리에 원래 node를 적어 둔다
+    for (node_t *p = subtree_min(t, t->root); p != t->nil; p = rbtree_successor(t, p), i++)
+    {
+      nodes[i].key = p->key;
+      nodes[i].color = p->color;
+      nodes[i].size = p->size;
+      nodes[i].parent = p;
+    }
+
+    // 2. 원래 링크를 가져오고, 다 읽은 원래 node의 size에 새 index를 남긴다
+    for (i = 0; i < n; i++)
+    {
+      node_t *old = nodes[i].parent;
+      nodes[i].left = old->left;
+      nodes[i].right = old->right;
+      nodes[i].parent = old->parent;
+      old->size = i;
+    }
+
+    // 3. 원래 node를 가리키던 링크를 새 자리로 바꾼다
+    for (i = 0; i < n; i++)
+    {
+      nodes[i].left = rbtree_relocated(t, nodes, nodes[i].left);
+      nodes[i].right = rbtree_relocated(t, nodes, nodes[i].right);
+      nodes[i].parent = rbtree_relocated(t, nodes, nodes[i].parent);
+    }
+    t->root = rbtree_relocated(t, nodes, t->root);
+  }
+
+  rbtree_slab *slab = t->slabs;
+  while (slab != NULL)
+  {
+    rbtree_slab *next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  t->slabs = compacted;
+  t->slab_used = n;
+  t->free_list = NULL;
+  t->free_trees = NULL;
+}
+
+static int rbtree_key_cmp(const void *a, const void *b)
+{
+  const key_t x = *(const key_t *)a, y = *(const key_t *)b;
+  return (x > y) - (x < y);
+}
+
+static key_t *rbtree_sorted_copy(const key_t *keys, const size_t n)
+{
+  key_t *sorted = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+
+  if (sorted == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) sorted[i] = keys[i];
+  qsort(sorted, n, sizeof(key_t), rbtree_key_cmp);
+  return sorted;
+}
+
+// finger x에서 위로 올라가며 key가 들어갈 자리를 포함하는 가장 가까운 서브트리의 루트를 찾는다.
+// key가 x->key 이상이면 왼쪽 자식에서 올라와 부모의 key가 key보다 큰 곳에서,
+// 작으면 오른쪽 자식에서 올라와 부모의 key가 key 이하인 곳에서 멈춘다.
+// 도중에 key가 범위를 벗어난 조상을 지나지 않았다면 *adjacent는 1이고,
+// 이때 finger 바로 옆 자리(key가 크면 오른쪽, 작으면 왼쪽)가 비어 있으면 거기에 붙이면 된다.
+static node_t *rbtree_finger_climb(const rbtree *t, node_t *x, const key_t key, int *adjacent)
+{
+  const int up = x->key <= key;
+
+  *adjacent = 1;
+  while (x->parent != t->nil)
+  {
+    node_t *p = x->parent;
+    if (up && x == p->left)
+    {
+      if (key < p->key) break;
+      *adjacent = 0;
+    }
+    else if (!up && x == p->right)
+    {
+      if (p->key <= key) break;
+      *adjacent = 0;
+    }
+    x = p;
+  }
+  return x;
+}
+
+// 초기화된 z를 hint 근처에 연결한다. hint가 t->nil이면 루트부터 찾는다.
+static void rbtree_insert_near(rbtree *t, node_t *z, node_t *hint)
+{
+  if (hint == t->nil)
+  {
+    rbtree_insert_node(t, z, t->root);
+    return;
+  }
+
+  int adjacent;
+  node_t *from = rbtree_finger_climb(t, hint, z->key, &adjacent);
+  const int right = hint->key <= z->key;
+
+  if (!adjacent || (right ? hint->right : hint->left) != t->nil)
+  {
+    rbtree_insert_node(t, z, from);
+    return;
+  }
+
+  // hint 바로 옆이 z의 자리: 비교 없이 붙이고 조상들의 크기만 갱신한다
+  for (node_t *p = hint; p != t->nil; p = p->parent) p->size++;
+  RBTREE_STAT_DEPTH(t, 0);
+  z->parent = hint;
+  if (right)  hint->right = z;
+  else        hint->left = z;
+  rbtree_insert_fixup(t, z);
+}
+
+node_t *rbtree_insert_hint(rbtree *t, node_t *hint, const key_t key) {
+  // 근처에 있는 node에서부터 위아래로 자리를 찾는다. hint가 NULL이면 rbtree_insert와 같다.
+  if (t->counted)
+  {
+    node_t *p = rbtree_find_from(t, hint, key);
+    if (p != NULL) return rbtree_count_add(t, p);
+  }
+
+  node_t *z = rbtree_node_alloc(t);
+
+  rbtree_node_init(t, z, key);
+  rbtree_insert_near(t, z, (hint == NULL) ? t->nil : hint);
+  return z;
+}
+
+node_t *rbtree_find_from(const rbtree *t, node_t *finger, const key_t key) {
+  // finger에서 위로 올라가 key가 있을 수 있는 가장 가까운 서브트리를 찾은 뒤 아래로 내려간다.
+  // 같은 key가 여럿이면 그중 하나를 반환한다. finger가 NULL이면 rbtree_find와 같다.
+  if (finger == NULL) return rbtree_find(t, key);
+
+  const int up = finger->key < key;
+  node_t *x = finger;
+
+  while (x->key != key && x->parent != t->nil)
+  {
+    node_t *p = x->parent;
+    if (p->key == key) return p;
+    if (up ? (x == p->left && key < p->key) : (x == p->right && p->key < key)) break;
+    x = p;
+  }
+
+  while (x != t->nil)
+  {
+    if (x->key > key)         x = x->left;
+    else if (x->key < key)    x = x->right;
+    else                      return x;
+  }
+  return NULL;
+}
+
+void rbtree_insert_batch(rbtree *t, const key_t *keys, const size_t n) {
+  // 정렬한 뒤 직전에 넣은 node를 hint로 삼으므로 비슷한 key끼리는 루트부터 다시 내려가지 않는다.
+  // free list가 비면 남은 node를 한 block으로 미리 할당한다.
+  key_t *sorted = rbtree_sorted_copy(keys, n);
+  node_t *block = NULL;
+  node_t *finger = t->nil;
+
+  if (t->counted)                                        // 같은 key는 node를 늘리지 않으므로 미리 할당하지 않는다
+  {
+    node_t *hint = NULL;
+    for (size_t i = 0; i < n; i++) hint = rbtree_insert_hint(t, hint, sorted[i]);
+    free(sorted);
+    return;
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    node_t *z;
+    if (t->free_list != NULL || t->free_trees != NULL)
+    {
+      z = rbtree_node_alloc(t);
+    }
+    else
+    {
+      if (block == NULL) block = rbtree_reserve_nodes(t, n - i);
+      z = block++;
+    }
+
+    rbtree_node_init(t, z, sorted[i]);
+    rbtree_insert_near(t, z, finger);
+    finger = z;                                          // 회전이 일어나도 z는 같은 node
+  }
+
+  free(sorted);
+}
+
+size_t rbtree_erase_batch(rbtree *t, const key_t *keys, const size_t n) {
+  // 정렬한 뒤 직전에 지운 node의 successor(finger)에서부터 다음 key를 찾는다.
+  // key 하나당 하나씩 지우고, 트리에 없는 key는 건너뛴다. 지운 key 수를 반환한다.
+  key_t *sorted = rbtree_sorted_copy(keys, n);
+  node_t *finger = NULL;
+  size_t erased = 0;
+
+  for (size_t i = 0; i < n; i++)
+  {
+    node_t *z = rbtree_find_from(t, finger, sorted[i]);
+    if (z == NULL) continue;
+
+    finger = rbtree_successor(t, z);                     // erase는 node를 옮기지 않으므로 그대로 유효하다
+    if (finger == t->nil) finger = NULL;
+    rbtree_erase(t, z);
+    erased++;
+  }
+
+  free(sorted);
+  return erased;
+}
+
+size_t rbtree_erase_range(rbtree *t, const key_t lo, const key_t hi) {
+  // 트리를 < lo, [lo, hi], > hi 세 조각으로 나누고 양 끝만 다시 join한다
+  if (lo > hi) return 0;
+
+  node_t *first = rbtree_lower_bound(t, lo);
+  if (first == NULL || first->key > hi) return 0;        // 지울 것이 없으면 트리를 건드리지 않는다
+
+  node_t *left, *rest, *mid, *right;
+  rbtree_split_subtree(t, t->root, lo, 0, &left, &rest);
+  rbtree_split_subtree(t, rest, hi, 1, &mid, &right);
+  t->root = rbtree_join2_subtrees(t, left, right);
+
+  // 떼어낸 서브트리는 루트만 free_trees에 쌓아 두고, node는 rbtree_node_alloc이 하나씩 꺼낸다
+  RBTREE_STAT_ADD(t, node_frees, rbtree_subtree_nodes(t, mid));
+  mid->parent = t->free_trees;
+  t->free_trees = mid;
+  return mid->size;
+}
+
+// 서브트리 r을 독립된 트리로 떼어낸다. 루트를 black으로 칠해도 RB 조건은 유지된다.
+static node_t *rbtree_detach_subtree(const rbtree *t, node_t *r)
+{
+  if (r != t->nil)
+  {
+    r->parent = t->nil;
+    r->color = RBTREE_BLACK;
+  }
+  return r;
+}
+
+// r부터 nil 직전까지 한 경로 위의 black node 수 (r 자신 포함). 왼쪽 spine을 따라 O(log n).
+static int rbtree_black_height(const rbtree *t, const node_t *r)
+{
+  int h = 0;
+
+  for (; r != t->nil; r = r->left)
+  {
+    if (r->color == RBTREE_BLACK) h++;
+  }
+  return h;
+}
+
+// 아래의 join/split은 서브트리의 black 높이를 인자로 받고 결과의 높이를 돌려주어 spine을 다시 훑지 않는다.
+// 높이는 node의 현재 색으로 센 값이며, red 루트를 떼어내 black으로 칠하면 1 늘어난다.
+static int rbtree_detached_height(const rbtree *t, const node_t *r, const int h)
+{
+  return h + (r != t->nil && r->color == RBTREE_RED);
+}
+
+// 두 트리의 black 높이 차이만큼만 내려가므로 O(|hl - hr| + 1). 결과의 높이는 *h에 둔다.
+static node_t *rbtree_join_bh(const rbtree *t, node_t *l, int hl, node_t *k, node_t *r, int hr, int *h)
+{
+  node_t *nil = t->nil;
+  const size_t kc = t->counted ? k->size : 1;           // k 자신의 multiplicity
+
+  hl = rbtree_detached_height(t, l, hl);
+  hr = rbtree_detached_height(t, r, hr);
+  l = rbtree_detach_subtree(t, l);
+  r = rbtree_detach_subtree(t, r);
+
+  if (hl == hr)                                          // 높이가 같으면 k가 새 루트
+  {
+    k->left = l;
+    k->right = r;
+    k->parent = nil;
+    k->color = RBTREE_BLACK;
+    k->size = l->size + r->size + kc;
+    if (l != nil) l->parent = k;
+    if (r != nil) r->parent = k;
+    *h = hl + 1;
+    return k;
+  }
+
+  // 높은 쪽 트리의 안쪽 spine을 따라 낮은 쪽과 black 높이가 같은 black node c를 찾는다
+  const int taller_left = hl > hr;
+  node_t *other = taller_left ? r : l;
+  const int target = taller_left ? hr : hl;
+  const int taller = taller_left ? hl : hr;
+  int ch = taller;
+  rbtree sub = { .root = taller_left ? l : r, .nil = nil };
+  node_t *c = sub.root, *parent = nil;
+
+  while (!(c->color == RBTREE_BLACK && ch == target))
+  {
+    if (c->color == RBTREE_BLACK) ch--;
+    parent = c;
+    c = taller_left ? c->right : c->left;
+  }
+
+  // c 자리에 red k를 끼우고 c와 낮은 쪽 트리를 k의 자식으로 둔다
+  if (taller_left) { k->left = c; k->right = other; parent->right = k; }
+  else             { k->left = other; k->right = c; parent->left = k; }
+  k->parent = parent;
+  k->color = RBTREE_RED;
+  k->size = c->size + other->size + kc;
+  if (c != nil) c->parent = k;
+  if (other != nil) other->parent = k;
+  for (node_t *p = parent; p != nil; p = p->parent) p->size += other->size + kc;
+
+  // 남은 위반은 k와 부모의 red-red 뿐이므로 삽입과 같은 fixup으로 고친다
+  *h = taller + rbtree_insert_fixup(&sub, k);
+  return sub.root;
+}
+
+node_t *rbtree_join_subtrees(const rbtree *t, node_t *l, node_t *k, node_t *r) {
+  // l의 모든 key <= k->key <= r의 모든 key 일 때 세 부분을 하나의 RB 트리로 합친다.
+  // 양쪽 black 높이를 한 번씩 세므로 O(log n).
+  int h;
+
+  return rbtree_join_bh(t, l, rbtree_black_height(t, l), k, r, rbtree_black_height(t, r), &h);
+}
+
+// root(black 높이 h)를 lo와 hi로 나누고 각각의 높이를 *hlo, *hhi에 둔다.
+// 내려가며 자식의 높이를 h에서 바로 구하고 올라오며 join하는데, 올라오며 만드는 트리의 높이는
+// 매번 많아야 1~2씩 자라므로 join 비용의 합이 망원급수가 되어 전체 O(log n)이다.
+static void rbtree_split_bh(const rbtree *t, node_t *root, const int h, const key_t key, const int inclusive,
+                            node_t **lo, int *hlo, node_t **hi, int *hhi)
+{
+  if (root == t->nil)
+  {
+    *lo = *hi = t->nil;
+    *hlo = *hhi = 0;
+    return;
+  }
+
+  node_t *l = root->left, *r = root->right;
+  const int hc = h - (root->color == RBTREE_BLACK);      // 두 자식의 black 높이
+  const int goes_hi = inclusive ? key < root->key : key <= root->key;
+
+  root->size -= l->size + r->size;                       // join에 넘기도록 root의 multiplicity만 남긴다
+  node_t *a, *b;
+  int ha, hb;
+
+  if (goes_hi)
+  {
+    rbtree_split_bh(t, l, hc, key, inclusive, &a, &ha, &b, &hb);
+    *hlo = rbtree_detached_height(t, a, ha);
+    *lo = rbtree_detach_subtree(t, a);
+    *hi = rbtree_join_bh(t, b, hb, root, r, hc, hhi);
+  }
+  else
+  {
+    rbtree_split_bh(t, r, hc, key, inclusive, &a, &ha, &b, &hb);
+    *lo = rbtree_join_bh(t, l, hc, root, a, ha, hlo);
+    *hhi = rbtree_detached_height(t, b, hb);
+    *hi = rbtree_detach_subtree(t, b);
+  }
+}
+
+void rbtree_split_subtree(const rbtree *t, node_t *root, const key_t key, const int inclusive,
+                          node_t **lo, node_t **hi) {
+  // root를 key보다 작은(inclusive면 작거나 같은) node들의 트리 lo와 나머지 hi로 나눈다. O(log n).
+  int hlo, hhi;
+
+  rbtree_split_bh(t, root, rbtree_black_height(t, root), key, inclusive, lo, &hlo, hi, &hhi);
+}
+
+// root(black 높이 h)에서 최댓값 node를 떼어내 반환하고 나머지 트리와 그 높이를 rest, *hrest에 둔다
+static node_t *rbtree_split_last(const rbtree *t, node_t *root, const int h, node_t **rest, int *hrest)
+{
+  const int hc = h - (root->color == RBTREE_BLACK);
+
+  root->size -= root->left->size + root->right->size;
+  if (root->right == t->nil)
+  {
+    *hrest = rbtree_detached_height(t, root->left, hc);
+    *rest = rbtree_detach_subtree(t, root->left);
+    return root;
+  }
+
+  node_t *l = root->left, *r;
+  int hr;
+  node_t *last = rbtree_split_last(t, root->right, hc, &r, &hr);
+  *rest = rbtree_join_bh(t, l, hc, root, r, hr, hrest);
+  return last;
+}
+
+node_t *rbtree_join2_subtrees(const rbtree *t, node_t *l, node_t *r) {
+  // 가운데 key 없이 두 트리를 합친다 (l의 모든 key <= r의 모든 key). O(log n).
+  if (l == t->nil) return rbtree_detach_subtree(t, r);
+  if (r == t->nil) return rbtree_detach_subtree(t, l);
+
+  node_t *rest;
+  int hrest, h;
+  node_t *k = rbtree_split_last(t, l, rbtree_black_height(t, l), &rest, &hrest);
+  return rbtree_join_bh(t, rest, hrest, k, r, rbtree_black_height(t, r), &h);
 }
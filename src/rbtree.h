@@ -7,26 +7,176 @@ typedef enum { RBTREE_RED, RBTREE_BLACK } color_t;
 
 typedef int key_t;
 
+#define RBTREE_STATS_DEPTH 64
+
+// 재균형 작업량과 할당을 세는 카운터. RBTREE_STATS를 정의하고 빌드했을 때만 쌓인다.
+typedef struct {
+  size_t rotations;
+  size_t recolors;
+  size_t insert_fixup_loops;    // rbtree_insert_fixup의 반복 횟수
+  size_t erase_fixup_loops;     // rb_delete_fixup의 반복 횟수
+  size_t node_allocs;           // slab이나 free list에서 꺼낸 node 수 (미리 예약한 node 포함)
+  size_t node_frees;            // free list로 돌려준 node 수 (erase_range로 떼어낸 서브트리의 node 포함)
+  size_t slab_allocs;
+  size_t insert_depth[RBTREE_STATS_DEPTH];  // 삽입할 자리까지 내려간 깊이별 횟수, 마지막 칸은 그 이상
+} rbtree_stats_t;
+
+#ifdef RBTREE_BTREE
+
+// B-tree engine: RBTREE_BTREE를 정의하고 컴파일한 뒤 librbtree.a 대신 librbtree_btree.a를 링크한다.
+// key를 정렬된 배열로 담는 B+-tree로, leaf는 128byte(cache line 2개), 내부 node는 분리 key 15개가
+// 첫 cache line에 모여 있어 탐색 한 level에 cache line 두세 개만 읽는다.
+// node_t는 leaf 안의 key 한 칸이므로 insert나 erase를 하면 같은 트리의 node_t*는 모두 무효가 된다.
+// erase는 같은 key 중 하나를 지운다. counted 모드와 join/split 저수준 API는 없다.
+#define RBTREE_BTREE_LEAF_BYTES 128
+#define RBTREE_BTREE_LEAF_KEYS 27
+#define RBTREE_BTREE_FANOUT 16
+
+typedef struct node_t {
+  key_t key;
+} node_t;
+
+// RBTREE_BTREE_LEAF_BYTES 경계에 맞춰 할당하므로 node_t*의 주소만으로 leaf를 찾는다
+typedef struct rbtree_bleaf {
+  struct rbtree_bleaf *prev, *next;
+  int n;
+  node_t slots[RBTREE_BTREE_LEAF_KEYS];
+} rbtree_bleaf;
+
+// keys[i]는 child[i]의 모든 key 이상이고 child[i + 1]의 모든 key 이하다
+typedef struct rbtree_bnode {
+  key_t keys[RBTREE_BTREE_FANOUT - 1];
+  int n;                                 // 자식 수
+  void *child[RBTREE_BTREE_FANOUT];
+  size_t count[RBTREE_BTREE_FANOUT];     // 자식 서브트리의 key 수
+} rbtree_bnode;
+
+typedef struct {
+  void *root;             // height가 0이면 rbtree_bleaf, 아니면 rbtree_bnode. 빈 트리는 NULL
+  int height;
+  size_t size;
+  rbtree_bleaf *first, *last;
+  node_t end;             // to_array_batch가 끝까지 내보낸 cursor
+} rbtree;
+
+#else
+
 typedef struct node_t {
   color_t color;
   key_t key;
   struct node_t *parent, *left, *right;
+  size_t size;  // 이 node를 루트로 하는 서브트리의 key 수 (nil은 0, counted 트리에서는 multiplicity의 합)
 } node_t;
 
+typedef struct rbtree_slab rbtree_slab;
+
 typedef struct {
   node_t *root;
   node_t *nil;  // for sentinel
+
+  // node allocator: slab 목록과 재사용을 위한 free list
+  rbtree_slab *slabs;
+  size_t slab_used;       // 가장 최근 slab에서 사용한 node 수
+  node_t *free_list;
+  node_t *free_trees;     // erase_range로 떼어낸 서브트리의 루트들. 할당할 때 루트부터 하나씩 꺼낸다
+
+  int counted;            // 1이면 같은 key를 node 하나에 모아 센다 (new_rbtree_counted)
+
+#ifdef RBTREE_STATS
+  rbtree_stats_t stats;
+#endif
 } rbtree;
 
+#endif  // RBTREE_BTREE
+
+typedef int (*rbtree_visit_fn)(node_t *, void *);
+
+// rbtree_to_array_batch가 다음에 내보낼 위치. {NULL, 0}으로 초기화하면 최솟값부터 시작한다.
+// counted 트리에서는 multiplicity가 page보다 큰 node를 여러 page에 나눠 쓰도록 node 안의 위치도 기억한다.
+typedef struct {
+  node_t *node;
+  size_t offset;  // node의 key 중 이미 내보낸 개수
+} rbtree_cursor;
+
 rbtree *new_rbtree(void);
+rbtree *new_rbtree_with_capacity(const size_t);
+#ifndef RBTREE_BTREE
+// 같은 key를 node 하나의 multiplicity로 세는 multiset. 중복이 많은 입력에서 node 수가 distinct key 수로 줄어든다.
+// node의 multiplicity는 size - left->size - right->size이므로 node 크기는 그대로다.
+// insert는 같은 key의 node가 있으면 그 node를 반환하고 개수만 올리며, erase는 개수를 내려 0이 될 때만 node를 뺀다.
+// size, rank, select, to_array, range는 중복을 풀어 쓴 multiset과 같은 값을 내고,
+// next/prev와 range_foreach는 key마다 node 하나씩만 방문한다.
+rbtree *new_rbtree_counted(void);
+#endif
+rbtree *rbtree_from_sorted_array(const key_t *, const size_t);
 void delete_rbtree(rbtree *);
 
 node_t *rbtree_insert(rbtree *, const key_t);
+node_t *rbtree_insert_hint(rbtree *, node_t *, const key_t);
+void rbtree_insert_batch(rbtree *, const key_t *, const size_t);
 node_t *rbtree_find(const rbtree *, const key_t);
+node_t *rbtree_find_from(const rbtree *, node_t *, const key_t);
+size_t rbtree_find_batch(const rbtree *, const key_t *, const size_t, node_t **);
 node_t *rbtree_min(const rbtree *);
 node_t *rbtree_max(const rbtree *);
 int rbtree_erase(rbtree *, node_t *);
+size_t rbtree_erase_batch(rbtree *, const key_t *, const size_t);
+// [lo, hi] 구간의 key를 모두 지우고 지운 key 수를 반환한다. lo > hi이면 아무것도 지우지 않는다.
+// split 두 번과 join 한 번(각각 O(log n), 아래 저수준 API 참고)으로 구간을 떼어내고, 떼어낸 k개의 node는
+// 순회하지 않고 서브트리째로 보관했다가 이후 할당에서 하나씩 재사용한다. B-tree engine에서는 key를 하나씩 지운다.
+size_t rbtree_erase_range(rbtree *, const key_t, const key_t);
 
 int rbtree_to_array(const rbtree *, key_t *, const size_t);
+// cursor부터 최대 n개를 기록하고 cursor를 그 다음으로 옮긴다. 0을 반환하면 끝까지 내보낸 것이다.
+size_t rbtree_to_array_batch(const rbtree *, rbtree_cursor *, key_t *, const size_t);
+
+node_t *rbtree_next(const rbtree *, const node_t *);
+node_t *rbtree_prev(const rbtree *, const node_t *);
+node_t *rbtree_lower_bound(const rbtree *, const key_t);
+node_t *rbtree_upper_bound(const rbtree *, const key_t);
+size_t rbtree_range(const rbtree *, const key_t, const key_t, key_t *, const size_t);
+size_t rbtree_range_foreach(const rbtree *, const key_t, const key_t, rbtree_visit_fn, void *);
+
+size_t rbtree_size(const rbtree *);
+node_t *rbtree_select(const rbtree *, const size_t);
+size_t rbtree_rank(const rbtree *, const key_t);
+// node가 나타내는 key의 개수. counted 트리가 아니면 항상 1.
+size_t rbtree_count(const rbtree *, const node_t *);
+
+// 카운터를 out에 복사하고 1을 반환한다. RBTREE_STATS 없이 빌드했으면 out을 0으로 채우고 0을 반환.
+// rbtree_find처럼 트리를 바꾸지 않는 연산과 join/split 내부의 회전은 세지 않는다. B-tree engine에서는 항상 0.
+int rbtree_stats(const rbtree *, rbtree_stats_t *);
+void rbtree_stats_reset(rbtree *);
+
+#ifndef RBTREE_BTREE
+typedef struct {
+  size_t nodes;          // 트리에 연결된 node 수
+  size_t free_nodes;     // slab에 있지만 트리에 없는 node 칸 (free list, erase_range로 떼어낸 서브트리, 아직 안 쓴 칸)
+  size_t slabs;
+  size_t bytes;          // rbtree 구조체, nil, slab을 합친 byte 수
+  double fragmentation;  // in-order로 이웃한 node 쌍 중 메모리에서 바로 옆이 아닌 비율. 0이면 완전히 연속
+} rbtree_memory_t;
+
+// 트리가 쓰는 메모리를 out에 채운다. node를 in-order로 한 번 훑으므로 O(n).
+void rbtree_memory_usage(const rbtree *, rbtree_memory_t *);
+// node를 in-order 순서로 연속된 slab 하나에 옮겨 다시 연결하고, 이전 slab과 free list는 모두 반환한다.
+// 트리의 내용과 모양은 그대로지만 이전에 받은 node_t*는 모두 무효가 된다.
+// 추가 메모리는 새 slab 하나이며, 삽입/삭제가 많이 쌓인 뒤 scan 전에 부르면 cache와 TLB miss가 줄어든다.
+void rbtree_compact(rbtree *);
+#endif
+
+#ifndef RBTREE_BTREE
+
+// join/split 기반 bulk 연산을 위한 저수준 API. 모두 트리 t에 속한 node만 다루며,
+// 서브트리는 루트 node로 나타내고 결과 트리의 루트는 parent가 t->nil인 black node다.
+// counted 트리에서는 join의 가운데 node k의 size에 k 자신의 multiplicity를 담아 넘긴다.
+// 각 함수는 black 높이를 한 번만 세고 내부에서는 높이를 넘겨 주므로 join, join2, split 모두 O(log n)이다.
+node_t *rbtree_reserve_nodes(rbtree *, const size_t);
+void rbtree_release_nodes(rbtree *, node_t *, node_t *);
+node_t *rbtree_build_sorted(rbtree *, node_t *, const key_t *, size_t, size_t, node_t *, int, int);
+node_t *rbtree_join_subtrees(const rbtree *, node_t *, node_t *, node_t *);
+node_t *rbtree_join2_subtrees(const rbtree *, node_t *, node_t *);
+void rbtree_split_subtree(const rbtree *, node_t *, const key_t, const int, node_t **, node_t **);
+#endif
 
 #endif  // _RBTREE_H_
@@ -0,0 +1,734 @@
+#include "rbtree.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// rbtree.h의 API를 B+-tree로 구현한 engine. RBTREE_BTREE를 정의하고 컴파일한다.
+// leaf는 이중 연결 리스트로 이어져 있어 순회는 배열을 차례로 읽는 것과 같고,
+// 내부 node는 자식별 key 수를 들고 있어 select/rank도 O(log n)이다.
+
+#define LEAF_MIN (RBTREE_BTREE_LEAF_KEYS / 2)   // 루트가 아닌 leaf의 최소 key 수
+#define NODE_MIN (RBTREE_BTREE_FANOUT / 2)      // 루트가 아닌 내부 node의 최소 자식 수
+
+_Static_assert(sizeof(rbtree_bleaf) == RBTREE_BTREE_LEAF_BYTES, "leaf must fill its aligned block");
+
+static void *bt_alloc(size_t align, size_t size)
+{
+  void *p = aligned_alloc(align, size);
+
+  if (p == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return p;
+}
+
+static rbtree_bleaf *bt_new_leaf(void)
+{
+  rbtree_bleaf *l = (rbtree_bleaf *)bt_alloc(RBTREE_BTREE_LEAF_BYTES, sizeof(rbtree_bleaf));
+
+  l->prev = l->next = NULL;
+  l->n = 0;
+  return l;
+}
+
+static rbtree_bnode *bt_new_node(void)
+{
+  rbtree_bnode *b = (rbtree_bnode *)bt_alloc(64, sizeof(rbtree_bnode));
+
+  b->n = 0;
+  return b;
+}
+
+// node_t는 leaf 안의 한 칸이므로 주소를 leaf 크기로 내림하면 그 leaf다
+static rbtree_bleaf *bt_leaf_of(const node_t *p)
+{
+  return (rbtree_bleaf *)((uintptr_t)p & ~(uintptr_t)(RBTREE_BTREE_LEAF_BYTES - 1));
+}
+
+// keys[0, n)에서 key보다 작은(upper면 작거나 같은) 것의 개수
+static int bt_search(const key_t *keys, const int n, const key_t key, const int upper)
+{
+  int lo = 0, hi = n;
+
+  while (lo < hi)
+  {
+    const int mid = (lo + hi) / 2;
+    if (upper ? keys[mid] <= key : keys[mid] < key) lo = mid + 1;
+    else                                          hi = mid;
+  }
+  return lo;
+}
+
+static int bt_leaf_search(const rbtree_bleaf *l, const key_t key, const int upper)
+{
+  int lo = 0, hi = l->n;
+
+  while (lo < hi)
+  {
+    const int mid = (lo + hi) / 2;
+    if (upper ? l->slots[mid].key <= key : l->slots[mid].key < key) lo = mid + 1;
+    else                                                          hi = mid;
+  }
+  return lo;
+}
+
+static size_t bt_total(const void *x, const int h)
+{
+  if (h == 0) return (size_t)((const rbtree_bleaf *)x)->n;
+
+  const rbtree_bnode *b = (const rbtree_bnode *)x;
+  size_t total = 0;
+  for (int i = 0; i < b->n; i++) total += b->count[i];
+  return total;
+}
+
+rbtree *new_rbtree(void) {
+  rbtree *t = (rbtree *)calloc(1, sizeof(rbtree));
+
+  if (t == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return t;
+}
+
+rbtree *new_rbtree_with_capacity(const size_t capacity) {
+  (void)capacity;                                        // leaf는 필요할 때마다 따로 할당한다
+  return new_rbtree();
+}
+
+static void bt_free(void *x, const int h)
+{
+  if (h > 0)
+  {
+    rbtree_bnode *b = (rbtree_bnode *)x;
+    for (int i = 0; i < b->n; i++) bt_free(b->child[i], h - 1);
+  }
+  free(x);
+}
+
+void delete_rbtree(rbtree *t) {
+  if (t == NULL) return;
+
+  if (t->root != NULL) bt_free(t->root, t->height);      // 높이는 O(log n)이라 재귀가 깊지 않다
+  free(t);
+}
+
+rbtree *rbtree_from_sorted_array(const key_t *arr, const size_t n) {
+  // leaf를 고르게 채운 뒤 위 level을 차례로 쌓는다. 모든 node가 최소 크기 이상이 된다.
+  rbtree *t = new_rbtree();
+
+  if (n == 0) return t;
+
+  size_t m = (n + RBTREE_BTREE_LEAF_KEYS - 1) / RBTREE_BTREE_LEAF_KEYS;
+  void **level = (void **)malloc(m * sizeof(void *));
+  size_t *counts = (size_t *)malloc(m * sizeof(size_t));
+  key_t *mins = (key_t *)malloc(m * sizeof(key_t));
+  if (level == NULL || counts == NULL || mins == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  rbtree_bleaf *prev = NULL;
+  for (size_t i = 0, off = 0; i < m; i++)
+  {
+    rbtree_bleaf *l = bt_new_leaf();
+    l->n = (int)(n / m + (i < n % m));
+    for (int j = 0; j < l->n; j++) l->slots[j].key = arr[off + j];
+    off += l->n;
+    l->prev = prev;
+    if (prev != NULL) prev->next = l;
+    else              t->first = l;
+    prev = l;
+    level[i] = l;
+    counts[i] = l->n;
+    mins[i] = l->slots[0].key;
+  }
+  t->last = prev;
+
+  while (m > 1)
+  {
+    const size_t parents = (m + RBTREE_BTREE_FANOUT - 1) / RBTREE_BTREE_FANOUT;
+    for (size_t i = 0, off = 0; i < parents; i++)
+    {
+      rbtree_bnode *b = bt_new_node();
+      size_t total = 0;
+      b->n = (int)(m / parents + (i < m % parents));
+      for (int j = 0; j < b->n; j++)
+      {
+        b->child[j] = level[off + j];
+        b->count[j] = counts[off + j];
+        if (j > 0) b->keys[j - 1] = mins[off + j];
+        total += counts[off + j];
+      }
+      mins[i] = mins[off];
+      off += b->n;
+      level[i] = b;
+      counts[i] = total;
+    }
+    m = parents;
+    t->height++;
+  }
+
+  t->root = level[0];
+  t->size = n;
+  free(mins);
+  free(counts);
+  free(level);
+  return t;
+}
+
+// key를 x 서브트리에 넣고 넣은 칸을 *slot에 둔다.
+// x가 넘쳐 둘로 나뉘면 새 오른쪽 node를 반환하고 둘 사이의 분리 key를 *sep에 둔다.
+static void *bt_insert(rbtree *t, void *x, const int h, const key_t key, key_t *sep, node_t **slot)
+{
+  if (h == 0)
+  {
+    rbtree_bleaf *l = (rbtree_bleaf *)x;
+    const int pos = bt_leaf_search(l, key, 1);          // 같은 key들의 뒤에 넣는다
+
+    if (l->n < RBTREE_BTREE_LEAF_KEYS)
+    {
+      memmove(&l->slots[pos + 1], &l->slots[pos], (l->n - pos) * sizeof(node_t));
+      l->slots[pos].key = key;
+      l->n++;
+      *slot = &l->slots[pos];
+      return NULL;
+    }
+
+    // 가득 찬 leaf: key를 넣은 n + 1개를 반씩 나눈다
+    key_t tmp[RBTREE_BTREE_LEAF_KEYS + 1];
+    for (int i = 0; i < pos; i++)     tmp[i] = l->slots[i].key;
+    tmp[pos] = key;
+    for (int i = pos; i < l->n; i++)  tmp[i + 1] = l->slots[i].key;
+
+    rbtree_bleaf *r = bt_new_leaf();
+    const int half = (RBTREE_BTREE_LEAF_KEYS + 1) / 2;
+    l->n = half;
+    r->n = RBTREE_BTREE_LEAF_KEYS + 1 - half;
+    for (int i = 0; i < l->n; i++) l->slots[i].key = tmp[i];
+    for (int i = 0; i < r->n; i++) r->slots[i].key = tmp[half + i];
+
+    r->prev = l;
+    r->next = l->next;
+    if (l->next != NULL) l->next->prev = r;
+    else                 t->last = r;
+    l->next = r;
+
+    *slot = (pos < half) ? &l->slots[pos] : &r->slots[pos - half];
+    *sep = r->slots[0].key;
+    return r;
+  }
+
+  rbtree_bnode *b = (rbtree_bnode *)x;
+  const int i = bt_search(b->keys, b->n - 1, key, 1);
+  key_t s;
+
+  b->count[i]++;
+  void *nr = bt_insert(t, b->child[i], h - 1, key, &s, slot);
+  if (nr == NULL) return NULL;
+
+  // 자식 i가 나뉘었으니 오른쪽 조각을 i + 1에 끼운다
+  const size_t moved = bt_total(nr, h - 1);
+  b->count[i] -= moved;
+
+  key_t keys[RBTREE_BTREE_FANOUT];
+  void *child[RBTREE_BTREE_FANOUT + 1];
+  size_t count[RBTREE_BTREE_FANOUT + 1];
+  const int n = b->n + 1;
+
+  memcpy(keys, b->keys, i * sizeof(key_t));
+  keys[i] = s;
+  memcpy(keys + i + 1, b->keys + i, (b->n - 1 - i) * sizeof(key_t));
+  memcpy(child, b->child, (i + 1) * sizeof(void *));
+  child[i + 1] = nr;
+  memcpy(child + i + 2, b->child + i + 1, (b->n - 1 - i) * sizeof(void *));
+  memcpy(count, b->count, (i + 1) * sizeof(size_t));
+  count[i + 1] = moved;
+  memcpy(count + i + 2, b->count + i + 1, (b->n - 1 - i) * sizeof(size_t));
+
+  if (n <= RBTREE_BTREE_FANOUT)
+  {
+    memcpy(b->keys, keys, (n - 1) * sizeof(key_t));
+    memcpy(b->child, child, n * sizeof(void *));
+    memcpy(b->count, count, n * sizeof(size_t));
+    b->n = n;
+    return NULL;
+  }
+
+  // 넘친 node: 자식을 반씩 나누고 가운데 분리 key는 부모로 올린다
+  rbtree_bnode *r = bt_new_node();
+  const int half = n / 2;
+  b->n = half;
+  r->n = n - half;
+  memcpy(b->keys, keys, (half - 1) * sizeof(key_t));
+  memcpy(b->child, child, half * sizeof(void *));
+  memcpy(b->count, count, half * sizeof(size_t));
+  memcpy(r->keys, keys + half, (r->n - 1) * sizeof(key_t));
+  memcpy(r->child, child + half, r->n * sizeof(void *));
+  memcpy(r->count, count + half, r->n * sizeof(size_t));
+  *sep = keys[half - 1];
+  return r;
+}
+
+node_t *rbtree_insert(rbtree *t, const key_t key) {
+  node_t *slot;
+  key_t sep;
+
+  if (t->root == NULL)
+  {
+    rbtree_bleaf *l = bt_new_leaf();
+    t->root = t->first = t->last = l;
+    t->height = 0;
+  }
+
+  void *r = bt_insert(t, t->root, t->height, key, &sep, &slot);
+  if (r != NULL)                                         // 루트가 나뉘면 한 level 높아진다
+  {
+    rbtree_bnode *b = bt_new_node();
+    b->n = 2;
+    b->child[0] = t->root;
+    b->child[1] = r;
+    b->count[1] = bt_total(r, t->height);
+    b->count[0] = t->size + 1 - b->count[1];
+    b->keys[0] = sep;
+    t->root = b;
+    t->height++;
+  }
+  t->size++;
+  return slot;
+}
+
+node_t *rbtree_insert_hint(rbtree *t, node_t *hint, const key_t key) {
+  // 자식별 key 수를 갱신하려면 어차피 루트부터 내려가야 하므로 hint는 쓰지 않는다
+  (void)hint;
+  return rbtree_insert(t, key);
+}
+
+static int bt_key_cmp(const void *a, const void *b)
+{
+  const key_t x = *(const key_t *)a, y = *(const key_t *)b;
+  return (x > y) - (x < y);
+}
+
+static key_t *bt_sorted_copy(const key_t *keys, const size_t n)
+{
+  key_t *sorted = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+
+  if (sorted == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(sorted, keys, n * sizeof(key_t));
+  qsort(sorted, n, sizeof(key_t), bt_key_cmp);
+  return sorted;
+}
+
+void rbtree_insert_batch(rbtree *t, const key_t *keys, const size_t n) {
+  // 정렬해서 넣으면 연속된 key가 같은 leaf와 경로를 다시 밟으므로 cache에 남아 있다
+  key_t *sorted = bt_sorted_copy(keys, n);
+
+  for (size_t i = 0; i < n; i++) rbtree_insert(t, sorted[i]);
+  free(sorted);
+}
+
+node_t *rbtree_lower_bound(const rbtree *t, const key_t key) {
+  // 분리 key가 key보다 작은 자식들에는 key보다 작은 값만 있다
+  if (t->root == NULL) return NULL;
+
+  void *x = t->root;
+  for (int h = t->height; h > 0; h--)
+  {
+    const rbtree_bnode *b = (const rbtree_bnode *)x;
+    x = b->child[bt_search(b->keys, b->n - 1, key, 0)];
+  }
+
+  rbtree_bleaf *l = (rbtree_bleaf *)x;
+  const int pos = bt_leaf_search(l, key, 0);
+  if (pos < l->n)       return &l->slots[pos];
+  return (l->next != NULL) ? &l->next->slots[0] : NULL;
+}
+
+node_t *rbtree_upper_bound(const rbtree *t, const key_t key) {
+  if (t->root == NULL) return NULL;
+
+  void *x = t->root;
+  for (int h = t->height; h > 0; h--)
+  {
+    const rbtree_bnode *b = (const rbtree_bnode *)x;
+    x = b->child[bt_search(b->keys, b->n - 1, key, 1)];
+  }
+
+  rbtree_bleaf *l = (rbtree_bleaf *)x;
+  const int pos = bt_leaf_search(l, key, 1);
+  if (pos < l->n)       return &l->slots[pos];
+  return (l->next != NULL) ? &l->next->slots[0] : NULL;
+}
+
+node_t *rbtree_find(const rbtree *t, const key_t key) {
+  // 같은 key가 여럿이면 가장 앞의 것
+  node_t *p = rbtree_lower_bound(t, key);
+
+  return (p != NULL && p->key == key) ? p : NULL;
+}
+
+node_t *rbtree_find_from(const rbtree *t, node_t *finger, const key_t key) {
+  // finger의 leaf가 key를 감싸고 있으면 그 leaf만 찾는다. 결과는 rbtree_find와 같다.
+  if (finger != NULL)
+  {
+    rbtree_bleaf *l = bt_leaf_of(finger);
+    if (l->slots[0].key < key && key <= l->slots[l->n - 1].key)
+    {
+      const int pos = bt_leaf_search(l, key, 0);
+      return (l->slots[pos].key == key) ? &l->slots[pos] : NULL;
+    }
+  }
+  return rbtree_find(t, key);
+}
+
+size_t rbtree_find_batch(const rbtree *t, const key_t *keys, const size_t n, node_t **out) {
+  // 한 level에 cache line 두세 개만 읽으므로 rbtree engine처럼 탐색을 섞지 않는다
+  size_t found = 0;
+
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = rbtree_find(t, keys[i]);
+    found += (out[i] != NULL);
+  }
+  return found;
+}
+
+node_t *rbtree_min(const rbtree *t) {
+  return (t->first != NULL) ? &t->first->slots[0] : NULL;
+}
+
+node_t *rbtree_max(const rbtree *t) {
+  return (t->last != NULL) ? &t->last->slots[t->last->n - 1] : NULL;
+}
+
+node_t *rbtree_next(const rbtree *t, const node_t *p) {
+  (void)t;
+  rbtree_bleaf *l = bt_leaf_of(p);
+  const int i = (int)(p - l->slots);
+
+  if (i + 1 < l->n) return &l->slots[i + 1];
+  return (l->next != NULL) ? &l->next->slots[0] : NULL;
+}
+
+node_t *rbtree_prev(const rbtree *t, const node_t *p) {
+  (void)t;
+  rbtree_bleaf *l = bt_leaf_of(p);
+  const int i = (int)(p - l->slots);
+
+  if (i > 0) return &l->slots[i - 1];
+  return (l->prev != NULL) ? &l->prev->slots[l->prev->n - 1] : NULL;
+}
+
+// b의 자식 i와 i + 1을 왼쪽 자식 하나로 합치고 오른쪽 자식은 해제한다
+static void bt_merge(rbtree *t, rbtree_bnode *b, const int i, const int h)
+{
+  if (h == 0)
+  {
+    rbtree_bleaf *l = (rbtree_bleaf *)b->child[i], *r = (rbtree_bleaf *)b->child[i + 1];
+    memcpy(&l->slots[l->n], r->slots, r->n * sizeof(node_t));
+    l->n += r->n;
+    l->next = r->next;
+    if (r->next != NULL) r->next->prev = l;
+    else                 t->last = l;
+    free(r);
+  }
+  else
+  {
+    rbtree_bnode *l = (rbtree_bnode *)b->child[i], *r = (rbtree_bnode *)b->child[i + 1];
+    l->keys[l->n - 1] = b->keys[i];                      // 부모의 분리 key가 내려온다
+    memcpy(&l->keys[l->n], r->keys, (r->n - 1) * sizeof(key_t));
+    memcpy(&l->child[l->n], r->child, r->n * sizeof(void *));
+    memcpy(&l->count[l->n], r->count, r->n * sizeof(size_t));
+    l->n += r->n;
+    free(r);
+  }
+
+  b->count[i] += b->count[i + 1];
+  memmove(&b->keys[i], &b->keys[i + 1], (b->n - 2 - i) * sizeof(key_t));
+  memmove(&b->child[i + 1], &b->child[i + 2], (b->n - 2 - i) * sizeof(void *));
+  memmove(&b->count[i + 1], &b->count[i + 2], (b->n - 2 - i) * sizeof(size_t));
+  b->n--;
+}
+
+// 자식 i + 1의 첫 항목을 자식 i의 끝으로 옮긴다
+static void bt_shift_left(rbtree_bnode *b, const int i, const int h)
+{
+  if (h == 0)
+  {
+    rbtree_bleaf *l = (rbtree_bleaf *)b->child[i], *r = (rbtree_bleaf *)b->child[i + 1];
+    l->slots[l->n++] = r->slots[0];
+    memmove(&r->slots[0], &r->slots[1], (--r->n) * sizeof(node_t));
+    b->keys[i] = r->slots[0].key;
+    b->count[i]++;
+    b->count[i + 1]--;
+  }
+  else
+  {
+    rbtree_bnode *l = (rbtree_bnode *)b->child[i], *r = (rbtree_bnode *)b->child[i + 1];
+    const size_t moved = r->count[0];
+    l->keys[l->n - 1] = b->keys[i];
+    l->child[l->n] = r->child[0];
+    l->count[l->n] = moved;
+    l->n++;
+    b->keys[i] = r->keys[0];
+    memmove(&r->keys[0], &r->keys[1], (r->n - 2) * sizeof(key_t));
+    memmove(&r->child[0], &r->child[1], (r->n - 1) * sizeof(void *));
+    memmove(&r->count[0], &r->count[1], (r->n - 1) * sizeof(size_t));
+    r->n--;
+    b->count[i] += moved;
+    b->count[i + 1] -= moved;
+  }
+}
+
+// 자식 i의 마지막 항목을 자식 i + 1의 앞으로 옮긴다
+static void bt_shift_right(rbtree_bnode *b, const int i, const int h)
+{
+  if (h == 0)
+  {
+    rbtree_bleaf *l = (rbtree_bleaf *)b->child[i], *r = (rbtree_bleaf *)b->child[i + 1];
+    memmove(&r->slots[1], &r->slots[0], (r->n++) * sizeof(node_t));
+    r->slots[0] = l->slots[--l->n];
+    b->keys[i] = r->slots[0].key;
+    b->count[i]--;
+    b->count[i + 1]++;
+  }
+  else
+  {
+    rbtree_bnode *l = (rbtree_bnode *)b->child[i], *r = (rbtree_bnode *)b->child[i + 1];
+    const size_t moved = l->count[l->n - 1];
+    memmove(&r->keys[1], &r->keys[0], (r->n - 1) * sizeof(key_t));
+    memmove(&r->child[1], &r->child[0], r->n * sizeof(void *));
+    memmove(&r->count[1], &r->count[0], r->n * sizeof(size_t));
+    r->keys[0] = b->keys[i];
+    r->child[0] = l->child[l->n - 1];
+    r->count[0] = moved;
+    r->n++;
+    b->keys[i] = l->keys[l->n - 2];
+    l->n--;
+    b->count[i] -= moved;
+    b->count[i + 1] += moved;
+  }
+}
+
+// 자식 i가 최소 크기보다 작아졌으면 형제에게서 빌리거나 형제와 합친다
+static void bt_fix_child(rbtree *t, rbtree_bnode *b, const int i, const int h)
+{
+  const int min = (h == 0) ? LEAF_MIN : NODE_MIN;
+  const int size = (h == 0) ? ((rbtree_bleaf *)b->child[i])->n : ((rbtree_bnode *)b->child[i])->n;
+
+  if (size >= min) return;
+
+  if (i > 0)
+  {
+    const int left = (h == 0) ? ((rbtree_bleaf *)b->child[i - 1])->n : ((rbtree_bnode *)b->child[i - 1])->n;
+    if (left > min) bt_shift_right(b, i - 1, h);
+    else            bt_merge(t, b, i - 1, h);
+  }
+  else
+  {
+    const int right = (h == 0) ? ((rbtree_bleaf *)b->child[1])->n : ((rbtree_bnode *)b->child[1])->n;
+    if (right > min) bt_shift_left(b, 0, h);
+    else             bt_merge(t, b, 0, h);
+  }
+}
+
+// x 서브트리에서 key 하나를 지우면 1
+static int bt_erase(rbtree *t, void *x, const int h, const key_t key)
+{
+  if (h == 0)
+  {
+    rbtree_bleaf *l = (rbtree_bleaf *)x;
+    const int pos = bt_leaf_search(l, key, 0);
+    if (pos == l->n || l->slots[pos].key != key) return 0;
+
+    memmove(&l->slots[pos], &l->slots[pos + 1], (l->n - pos - 1) * sizeof(node_t));
+    l->n--;
+    return 1;
+  }
+
+  // 분리 key가 key와 같으면 그 오른쪽 자식에도 key가 있을 수 있다
+  rbtree_bnode *b = (rbtree_bnode *)x;
+  for (int i = bt_search(b->keys, b->n - 1, key, 0); i < b->n; i++)
+  {
+    if (bt_erase(t, b->child[i], h - 1, key))
+    {
+      b->count[i]--;
+      bt_fix_child(t, b, i, h - 1);
+      return 1;
+    }
+    if (i == b->n - 1 || b->keys[i] != key) break;
+  }
+  return 0;
+}
+
+static int bt_erase_key(rbtree *t, const key_t key)
+{
+  if (t->root == NULL || !bt_erase(t, t->root, t->height, key)) return 0;
+
+  t->size--;
+  if (t->height > 0 && ((rbtree_bnode *)t->root)->n == 1)  // 자식이 하나 남은 루트는 걷어낸다
+  {
+    rbtree_bnode *b = (rbtree_bnode *)t->root;
+    t->root = b->child[0];
+    t->height--;
+    free(b);
+  }
+  else if (t->height == 0 && ((rbtree_bleaf *)t->root)->n == 0)
+  {
+    free(t->root);
+    t->root = NULL;
+    t->first = t->last = NULL;
+  }
+  return 1;
+}
+
+int rbtree_erase(rbtree *t, node_t *p) {
+  bt_erase_key(t, p->key);
+  return 0;
+}
+
+size_t rbtree_erase_batch(rbtree *t, const key_t *keys, const size_t n) {
+  key_t *sorted = bt_sorted_copy(keys, n);
+  size_t erased = 0;
+
+  for (size_t i = 0; i < n; i++) erased += bt_erase_key(t, sorted[i]);
+  free(sorted);
+  return erased;
+}
+
+size_t rbtree_erase_range(rbtree *t, const key_t lo, const key_t hi) {
+  // split/join이 없으므로 구간의 첫 key를 하나씩 지운다
+  size_t erased = 0;
+
+  if (lo > hi) return 0;
+  for (node_t *p = rbtree_lower_bound(t, lo); p != NULL && p->key <= hi; p = rbtree_lower_bound(t, lo))
+  {
+    erased += bt_erase_key(t, p->key);
+  }
+  return erased;
+}
+
+size_t rbtree_to_array_batch(const rbtree *t, rbtree_cursor *cursor, key_t *arr, const size_t n) {
+  // cursor->node가 NULL이면 최솟값부터 시작, &t->end면 이미 끝까지 내보낸 상태.
+  // node_t 하나가 key 하나이므로 offset은 항상 0이다.
+  node_t *p = (cursor->node == NULL) ? rbtree_min(t) : cursor->node;
+  size_t i = 0;
+
+  if (p == &t->end) return 0;
+  if (p != NULL)
+  {
+    rbtree_bleaf *l = bt_leaf_of(p);
+    int j = (int)(p - l->slots);
+
+    while (i < n && l != NULL)                           // leaf 안은 배열을 그대로 복사
+    {
+      int take = l->n - j;
+      if ((size_t)take > n - i) take = (int)(n - i);
+      for (int k = 0; k < take; k++) arr[i + k] = l->slots[j + k].key;
+      i += take;
+      j += take;
+      if (j == l->n)
+      {
+        l = l->next;
+        j = 0;
+      }
+    }
+    p = (l != NULL) ? &l->slots[j] : NULL;
+  }
+
+  cursor->node = (p == NULL) ? (node_t *)&t->end : p;
+  cursor->offset = 0;
+  return i;
+}
+
+int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n) {
+  rbtree_cursor cursor = {NULL, 0};
+
+  return (int)rbtree_to_array_batch(t, &cursor, arr, n);
+}
+
+size_t rbtree_range(const rbtree *t, const key_t lo, const key_t hi, key_t *arr, const size_t n) {
+  size_t i = 0;
+
+  for (node_t *p = rbtree_lower_bound(t, lo); i < n && p != NULL && p->key <= hi; p = rbtree_next(t, p))
+  {
+    arr[i++] = p->key;
+  }
+  return i;
+}
+
+size_t rbtree_range_foreach(const rbtree *t, const key_t lo, const key_t hi,
+                            rbtree_visit_fn fn, void *arg) {
+  size_t count = 0;
+
+  for (node_t *p = rbtree_lower_bound(t, lo); p != NULL && p->key <= hi; p = rbtree_next(t, p))
+  {
+    count++;
+    if (fn(p, arg) != 0) break;
+  }
+  return count;
+}
+
+size_t rbtree_size(const rbtree *t) {
+  return t->size;
+}
+
+node_t *rbtree_select(const rbtree *t, const size_t k) {
+  if (k >= t->size) return NULL;
+
+  void *x = t->root;
+  size_t rank = k;
+  for (int h = t->height; h > 0; h--)
+  {
+    const rbtree_bnode *b = (const rbtree_bnode *)x;
+    int i = 0;
+    while (rank >= b->count[i]) rank -= b->count[i++];
+    x = b->child[i];
+  }
+  return &((rbtree_bleaf *)x)->slots[rank];
+}
+
+size_t rbtree_rank(const rbtree *t, const key_t key) {
+  // key보다 작은 key의 개수: 내려가며 왼쪽 자식들의 key 수를 더한다
+  if (t->root == NULL) return 0;
+
+  void *x = t->root;
+  size_t rank = 0;
+  for (int h = t->height; h > 0; h--)
+  {
+    const rbtree_bnode *b = (const rbtree_bnode *)x;
+    const int i = bt_search(b->keys, b->n - 1, key, 0);
+    for (int j = 0; j < i; j++) rank += b->count[j];
+    x = b->child[i];
+  }
+  return rank + bt_leaf_search((const rbtree_bleaf *)x, key, 0);
+}
+
+size_t rbtree_count(const rbtree *t, const node_t *p) {
+  (void)t;
+  (void)p;
+  return 1;
+}
+
+int rbtree_stats(const rbtree *t, rbtree_stats_t *out) {
+  // 회전과 재색칠이 없는 engine이므로 카운터도 없다
+  (void)t;
+  memset(out, 0, sizeof(*out));
+  return 0;
+}
+
+void rbtree_stats_reset(rbtree *t) {
+  (void)t;
+}
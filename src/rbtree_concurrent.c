@@ -0,0 +1,137 @@
+#include "rbtree_concurrent.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CRBTREE_OPTIMISTIC_TRIES 8                      // lock 없이 읽기를 시도하는 횟수
+#define CRBTREE_MAX_DEPTH 256                            // 이보다 깊으면 쓰기와 겹친 것으로 본다
+
+// 쓰기와 동시에 읽는 필드는 relaxed atomic으로 읽어 컴파일러가 다시 읽거나 합치지 않게 한다
+#define LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+crbtree *new_crbtree(void) {
+  crbtree *c = (crbtree *)calloc(1, sizeof(crbtree));
+
+  if (c == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  c->tree = new_rbtree();
+  pthread_mutex_init(&c->write_lock, NULL);
+  atomic_init(&c->seq, 0);
+  return c;
+}
+
+void delete_crbtree(crbtree *c) {
+  if (c == NULL) return;
+
+  pthread_mutex_destroy(&c->write_lock);
+  delete_rbtree(c->tree);
+  free(c);
+}
+
+static void crbtree_write_begin(crbtree *c)
+{
+  pthread_mutex_lock(&c->write_lock);
+  atomic_store_explicit(&c->seq, atomic_load_explicit(&c->seq, memory_order_relaxed) + 1,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+}
+
+static void crbtree_write_end(crbtree *c)
+{
+  atomic_store_explicit(&c->seq, atomic_load_explicit(&c->seq, memory_order_relaxed) + 1,
+                        memory_order_release);
+  pthread_mutex_unlock(&c->write_lock);
+}
+
+void crbtree_insert(crbtree *c, const key_t key) {
+  crbtree_write_begin(c);
+  rbtree_insert(c->tree, key);
+  crbtree_write_end(c);
+}
+
+int crbtree_erase(crbtree *c, const key_t key) {
+  crbtree_write_begin(c);
+  node_t *p = rbtree_find(c->tree, key);
+  if (p != NULL) rbtree_erase(c->tree, p);
+  crbtree_write_end(c);
+  return p != NULL;
+}
+
+// lock 없이 lower bound를 찾는다. 탐색이 일관되지 않았으면 -1.
+static int crbtree_try_lower_bound(crbtree *c, const key_t key, key_t *out)
+{
+  const rbtree *t = c->tree;
+  const unsigned long s1 = atomic_load_explicit(&c->seq, memory_order_acquire);
+
+  if (s1 & 1) return -1;
+
+  node_t *nil = t->nil;
+  node_t *ptr = LOAD(t->root);
+  int found = 0;
+  key_t best = 0;
+
+  for (int depth = 0; ptr != nil; depth++)
+  {
+    if (ptr == NULL || depth == CRBTREE_MAX_DEPTH) return -1;   // 연결 중이거나 회전 중인 node
+    const key_t k = LOAD(ptr->key);
+    if (k < key)  ptr = LOAD(ptr->right);
+    else          { found = 1; best = k; ptr = LOAD(ptr->left); }
+  }
+
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&c->seq, memory_order_relaxed) != s1) return -1;
+
+  if (found && out != NULL) *out = best;
+  return found;
+}
+
+int crbtree_lower_bound(crbtree *c, const key_t key, key_t *out) {
+  for (int i = 0; i < CRBTREE_OPTIMISTIC_TRIES; i++)
+  {
+    int r = crbtree_try_lower_bound(c, key, out);
+    if (r >= 0) return r;
+  }
+
+  // 쓰기가 계속 겹치면 writer와 같은 lock을 잡고 읽는다
+  pthread_mutex_lock(&c->write_lock);
+  node_t *p = rbtree_lower_bound(c->tree, key);
+  if (p != NULL && out != NULL) *out = p->key;
+  pthread_mutex_unlock(&c->write_lock);
+  return p != NULL;
+}
+
+int crbtree_contains(crbtree *c, const key_t key) {
+  key_t k;
+
+  return crbtree_lower_bound(c, key, &k) && k == key;
+}
+
+size_t crbtree_size(crbtree *c) {
+  const rbtree *t = c->tree;
+
+  for (int i = 0; i < CRBTREE_OPTIMISTIC_TRIES; i++)
+  {
+    const unsigned long s1 = atomic_load_explicit(&c->seq, memory_order_acquire);
+    if (s1 & 1) continue;
+    node_t *root = LOAD(t->root);
+    const size_t size = (root == NULL) ? 0 : LOAD(root->size);
+    atomic_thread_fence(memory_order_acquire);
+    if (root != NULL && atomic_load_explicit(&c->seq, memory_order_relaxed) == s1) return size;
+  }
+
+  pthread_mutex_lock(&c->write_lock);
+  const size_t size = rbtree_size(c->tree);
+  pthread_mutex_unlock(&c->write_lock);
+  return size;
+}
+
+int crbtree_to_array(crbtree *c, key_t *arr, const size_t n) {
+  // 전체 순회는 일관된 결과를 위해 쓰기를 막고 수행한다
+  pthread_mutex_lock(&c->write_lock);
+  int written = rbtree_to_array(c->tree, arr, n);
+  pthread_mutex_unlock(&c->write_lock);
+  return written;
+}
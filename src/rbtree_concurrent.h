@@ -0,0 +1,34 @@
+#ifndef _RBTREE_CONCURRENT_H_
+#define _RBTREE_CONCURRENT_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "rbtree.h"
+
+// 여러 thread가 함께 쓰는 rbtree.
+// - 쓰기(insert/erase)는 write_lock으로 직렬화하고, 수정 전후로 seq를 1씩 올린다.
+// - 읽기는 lock 없이 트리를 탐색한 뒤 seq가 그대로인지 확인한다(seqlock).
+//   탐색 도중 쓰기가 있었으면 다시 시도하고, 계속 실패하면 write_lock을 잡고 읽는다.
+// node는 트리의 slab 안에서만 재사용되고 delete_crbtree 전까지 해제되지 않으므로
+// 낡은 포인터를 따라가더라도 유효한 메모리만 읽는다.
+// lock 없이 얻은 node 포인터는 곧바로 재사용될 수 있으므로 읽기 API는 key 값만 돌려준다.
+typedef struct {
+  rbtree *tree;
+  pthread_mutex_t write_lock;
+  atomic_ulong seq;  // 홀수이면 쓰기 진행 중
+} crbtree;
+
+crbtree *new_crbtree(void);
+void delete_crbtree(crbtree *);
+
+void crbtree_insert(crbtree *, const key_t);
+int crbtree_erase(crbtree *, const key_t);
+
+int crbtree_contains(crbtree *, const key_t);
+int crbtree_lower_bound(crbtree *, const key_t, key_t *);
+size_t crbtree_size(crbtree *);
+int crbtree_to_array(crbtree *, key_t *, const size_t);
+
+#endif  // _RBTREE_CONCURRENT_H_
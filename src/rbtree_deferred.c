@@ -0,0 +1,88 @@
+#include "rbtree_deferred.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct rbtree_deferred_item {
+  struct rbtree_deferred_item *next;
+  rbtree *tree;
+} rbtree_deferred_item;
+
+// 모든 호출이 함께 쓰는 queue와 해제 thread
+static pthread_mutex_t rbtree_deferred_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rbtree_deferred_ready = PTHREAD_COND_INITIALIZER;   // queue에 트리가 들어옴
+static pthread_cond_t rbtree_deferred_idle = PTHREAD_COND_INITIALIZER;    // pending이 0이 됨
+static rbtree_deferred_item *rbtree_deferred_head, *rbtree_deferred_tail;
+static size_t rbtree_deferred_pending;                  // queue에 있거나 해제 중인 트리 수
+static int rbtree_deferred_started;
+
+static void *rbtree_deferred_main(void *arg)
+{
+  (void)arg;
+  pthread_mutex_lock(&rbtree_deferred_lock);
+  for (;;)
+  {
+    while (rbtree_deferred_head == NULL) pthread_cond_wait(&rbtree_deferred_ready, &rbtree_deferred_lock);
+
+    rbtree_deferred_item *item = rbtree_deferred_head;
+    rbtree_deferred_head = item->next;
+    if (rbtree_deferred_head == NULL) rbtree_deferred_tail = NULL;
+    pthread_mutex_unlock(&rbtree_deferred_lock);
+
+    delete_rbtree(item->tree);                           // lock 밖에서 해제
+    free(item);
+
+    pthread_mutex_lock(&rbtree_deferred_lock);
+    if (--rbtree_deferred_pending == 0) pthread_cond_broadcast(&rbtree_deferred_idle);
+  }
+  return NULL;
+}
+
+// lock을 잡은 상태에서 부른다. thread를 만들었거나 이미 있으면 1.
+static int rbtree_deferred_start(void)
+{
+  if (rbtree_deferred_started) return 1;
+
+  pthread_t thread;
+  pthread_attr_t attr;
+  if (pthread_attr_init(&attr) != 0) return 0;
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  rbtree_deferred_started = (pthread_create(&thread, &attr, rbtree_deferred_main, NULL) == 0);
+  pthread_attr_destroy(&attr);
+  return rbtree_deferred_started;
+}
+
+void rbtree_delete_deferred(rbtree *t) {
+  if (t == NULL) return;
+
+  rbtree_deferred_item *item = (rbtree_deferred_item *)malloc(sizeof(rbtree_deferred_item));
+  if (item == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  item->next = NULL;
+  item->tree = t;
+
+  pthread_mutex_lock(&rbtree_deferred_lock);
+  if (!rbtree_deferred_start())
+  {
+    pthread_mutex_unlock(&rbtree_deferred_lock);
+    free(item);
+    delete_rbtree(t);
+    return;
+  }
+  if (rbtree_deferred_tail == NULL) rbtree_deferred_head = item;
+  else                              rbtree_deferred_tail->next = item;
+  rbtree_deferred_tail = item;
+  rbtree_deferred_pending++;
+  pthread_cond_signal(&rbtree_deferred_ready);
+  pthread_mutex_unlock(&rbtree_deferred_lock);
+}
+
+void rbtree_deferred_flush(void) {
+  pthread_mutex_lock(&rbtree_deferred_lock);
+  while (rbtree_deferred_pending > 0) pthread_cond_wait(&rbtree_deferred_idle, &rbtree_deferred_lock);
+  pthread_mutex_unlock(&rbtree_deferred_lock);
+}
@@ -0,0 +1,16 @@
+#ifndef _RBTREE_DEFERRED_H_
+#define _RBTREE_DEFERRED_H_
+
+#include "rbtree.h"
+
+// 큰 트리의 해제를 background thread에 넘긴다.
+// delete_rbtree는 node를 순회하지 않고 slab만 반환하지만, 수천만 node의 트리는 수백 MB를
+// 운영체제에 돌려주느라 호출한 thread를 오래 붙잡는다. rbtree_delete_deferred는 트리를 queue에
+// 넣기만 하고 바로 돌아오며, 처음 호출될 때 만든 thread 하나가 넣은 순서대로 delete_rbtree를 부른다.
+// 넘긴 뒤에는 트리와 그 node를 더 이상 쓰면 안 된다. thread를 만들 수 없으면 그 자리에서 해제한다.
+
+void rbtree_delete_deferred(rbtree *);
+// 지금까지 넘긴 트리가 모두 해제될 때까지 기다린다.
+void rbtree_deferred_flush(void);
+
+#endif  // _RBTREE_DEFERRED_H_
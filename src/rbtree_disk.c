@@ -0,0 +1,331 @@
+#include "rbtree_disk.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RBTREE_DISK_BUFFER 4096                          // 한 번에 파일로 내보내는 node 수
+#define RBTREE_DISK_FNV_OFFSET 0xcbf29ce484222325ull
+#define RBTREE_DISK_FNV_PRIME 0x100000001b3ull
+
+_Static_assert(sizeof(rbtree_disk_header) % _Alignof(rbtree_disk_node) == 0,
+               "node array must stay aligned right after the header");
+
+// FNV-1a를 8byte 단위로 적용한다. 이어서 부를 때는 앞 조각의 길이가 8의 배수여야 한다.
+static uint64_t rbtree_disk_checksum(uint64_t h, const void *buf, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)buf;
+
+  for (; len >= 8; p += 8, len -= 8)
+  {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    h = (h ^ w) * RBTREE_DISK_FNV_PRIME;
+  }
+  for (; len > 0; p++, len--) h = (h ^ *p) * RBTREE_DISK_FNV_PRIME;
+  return h;
+}
+
+typedef struct {
+  FILE *f;
+  uint64_t checksum;
+  size_t used;
+  int error;
+  rbtree_disk_node buf[RBTREE_DISK_BUFFER];
+} rbtree_disk_writer;
+
+static void rbtree_disk_flush(rbtree_disk_writer *w)
+{
+  if (w->used == 0) return;
+
+  w->checksum = rbtree_disk_checksum(w->checksum, w->buf, w->used * sizeof(rbtree_disk_node));
+  if (fwrite(w->buf, sizeof(rbtree_disk_node), w->used, w->f) != w->used) w->error = 1;
+  w->used = 0;
+}
+
+// n개의 node를 in-order로 기록한다. 재귀 없이 parent 포인터로 다음 node로 가며,
+// idx번째 node의 자식 index는 서브트리 크기로 바로 계산된다.
+static void rbtree_disk_emit(const rbtree *t, const size_t n, rbtree_disk_writer *w)
+{
+  const node_t *x = rbtree_min(t);
+
+  for (uint32_t idx = 0; idx < n; idx++, x = rbtree_next(t, x))
+  {
+    rbtree_disk_node *d = &w->buf[w->used++];
+    d->key = x->key;
+    d->color = x->color;
+    d->left = (x->left == t->nil) ? RBTREE_DISK_NIL : idx - (uint32_t)x->left->size + (uint32_t)x->left->left->size;
+    d->right = (x->right == t->nil) ? RBTREE_DISK_NIL : idx + 1 + (uint32_t)x->right->left->size;
+    if (w->used == RBTREE_DISK_BUFFER) rbtree_disk_flush(w);
+  }
+}
+
+int rbtree_disk_sync_dir(const char *path) {
+  const char *slash = strrchr(path, '/');
+  const size_t len = (slash == NULL) ? 1 : (slash == path) ? 1 : (size_t)(slash - path);
+  char *dir = (char *)malloc(len + 1);
+
+  if (dir == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(dir, (slash == NULL) ? "." : path, len);
+  dir[len] = '\0';
+
+  int err = 0;
+  const int fd = open(dir, O_RDONLY | O_DIRECTORY);
+  if (fd < 0 || fsync(fd) != 0) err = errno;
+  if (fd >= 0) close(fd);
+  free(dir);
+  errno = err;
+  return (err == 0) ? 0 : -1;
+}
+
+int rbtree_save(const rbtree *t, const char *path) {
+  const size_t n = rbtree_size(t);
+
+  if (t->counted)                                        // 파일 형식에 multiplicity를 담을 자리가 없다
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  if (n >= RBTREE_DISK_NIL)
+  {
+    errno = EFBIG;
+    return -1;
+  }
+
+  // 임시 파일에 다 쓰고 fsync 한 뒤 rename 하고 디렉터리까지 fsync 하므로,
+  // 중간에 실패하거나 전원이 꺼져도 path에는 이전 파일이나 새 파일 중 하나가 온전히 남는다
+  const size_t path_len = strlen(path);
+  char *tmp = (char *)malloc(path_len + sizeof(".tmp"));
+  rbtree_disk_writer *w = (rbtree_disk_writer *)calloc(1, sizeof(rbtree_disk_writer));
+  if (tmp == NULL || w == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(tmp, path, path_len);
+  memcpy(tmp + path_len, ".tmp", sizeof(".tmp"));
+
+  rbtree_disk_header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, RBTREE_DISK_MAGIC, sizeof(h.magic));
+  h.version = RBTREE_DISK_VERSION;
+  h.node_size = sizeof(rbtree_disk_node);
+  h.count = n;
+
+  int err = 0;
+  w->f = fopen(tmp, "wb");
+  if (w->f == NULL)
+  {
+    err = errno;
+    goto out;
+  }
+
+  w->checksum = RBTREE_DISK_FNV_OFFSET;
+  w->error = fwrite(&h, sizeof(h), 1, w->f) != 1;       // 자리만 잡아 두고 마지막에 다시 쓴다
+  rbtree_disk_emit(t, n, w);
+  rbtree_disk_flush(w);
+
+  h.root = (n == 0) ? RBTREE_DISK_NIL : (uint32_t)t->root->left->size;
+  h.checksum = w->checksum;
+  if (w->error || fseek(w->f, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, w->f) != 1 ||
+      fflush(w->f) != 0 || fsync(fileno(w->f)) != 0)
+  {
+    err = errno ? errno : EIO;
+  }
+  if (fclose(w->f) != 0 && err == 0) err = errno;
+  if (err == 0 && rename(tmp, path) != 0) err = errno;
+  if (err != 0)
+  {
+    unlink(tmp);
+    goto out;
+  }
+  if (rbtree_disk_sync_dir(path) != 0) err = errno;     // rename은 끝났으므로 실패해도 tmp는 이미 없다
+
+out:
+  free(w);
+  free(tmp);
+  errno = err;
+  return (err == 0) ? 0 : -1;
+}
+
+static int rbtree_disk_valid(const void *map, const size_t len)
+{
+  const rbtree_disk_header *h = (const rbtree_disk_header *)map;
+
+  if (len < sizeof(*h)) return 0;
+  if (memcmp(h->magic, RBTREE_DISK_MAGIC, sizeof(h->magic)) != 0) return 0;
+  if (h->version != RBTREE_DISK_VERSION || h->node_size != sizeof(rbtree_disk_node)) return 0;
+  if (h->count >= RBTREE_DISK_NIL) return 0;
+  if (len - sizeof(*h) != h->count * sizeof(rbtree_disk_node)) return 0;
+  if ((h->count == 0) ? h->root != RBTREE_DISK_NIL : h->root >= h->count) return 0;
+
+  const uint64_t sum = rbtree_disk_checksum(RBTREE_DISK_FNV_OFFSET, h + 1, len - sizeof(*h));
+  return sum == h->checksum;
+}
+
+rbtree_mapped *rbtree_load_mmap(const char *path) {
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+
+  if (fd < 0) return NULL;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  const size_t len = (size_t)st.st_size;
+  void *map = (len > 0) ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);                                             // mapping은 fd를 닫아도 유지된다
+  if (map == MAP_FAILED)
+  {
+    if (len == 0) errno = EINVAL;
+    return NULL;
+  }
+  if (!rbtree_disk_valid(map, len))
+  {
+    munmap(map, len);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  rbtree_mapped *m = (rbtree_mapped *)calloc(1, sizeof(rbtree_mapped));
+  if (m == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  m->map = map;
+  m->map_len = len;
+  m->header = (const rbtree_disk_header *)map;
+  m->nodes = (const rbtree_disk_node *)(m->header + 1);
+  return m;
+}
+
+void delete_rbtree_mapped(rbtree_mapped *m) {
+  if (m == NULL) return;
+
+  if (m->map != NULL) munmap(m->map, m->map_len);
+  delete_rbtree(m->tree);
+  free(m);
+}
+
+size_t rbtree_mapped_size(const rbtree_mapped *m) {
+  return (m->tree != NULL) ? rbtree_size(m->tree) : (size_t)m->header->count;
+}
+
+// 저장된 트리를 따라 내려가 key 이상인 첫 node의 index를 찾는다 (없으면 count).
+// node가 in-order로 놓여 있으므로 그 뒤의 node들이 곧 다음 key들이다.
+// checksum은 맞지만 자식 index가 순환하는 파일에서도 끝나도록, 현재 node가 있어야 할 index 구간
+// [lo, hi)를 함께 좁혀 가며 그 밖을 가리키는 링크는 nil로 본다. 구간이 매번 줄어드므로 최대 count번 내려간다.
+static size_t rbtree_mapped_lower_index(const rbtree_mapped *m, const key_t key)
+{
+  const size_t count = m->header->count;
+  size_t found = count;
+  size_t lo = 0, hi = count;
+  uint32_t i = m->header->root;
+
+  while (i >= lo && i < hi)                              // RBTREE_DISK_NIL은 항상 구간 밖
+  {
+    if (m->nodes[i].key < key)
+    {
+      lo = (size_t)i + 1;
+      i = m->nodes[i].right;
+    }
+    else
+    {
+      found = i;
+      hi = i;
+      i = m->nodes[i].left;
+    }
+  }
+  return found;
+}
+
+int rbtree_mapped_contains(const rbtree_mapped *m, const key_t key) {
+  if (m->tree != NULL) return rbtree_find(m->tree, key) != NULL;
+
+  const size_t i = rbtree_mapped_lower_index(m, key);
+  return i < m->header->count && m->nodes[i].key == key;
+}
+
+int rbtree_mapped_lower_bound(const rbtree_mapped *m, const key_t key, key_t *out) {
+  if (m->tree != NULL)
+  {
+    node_t *p = rbtree_lower_bound(m->tree, key);
+    if (p != NULL) *out = p->key;
+    return p != NULL;
+  }
+
+  const size_t i = rbtree_mapped_lower_index(m, key);
+  if (i >= m->header->count) return 0;
+  *out = m->nodes[i].key;
+  return 1;
+}
+
+size_t rbtree_mapped_range(const rbtree_mapped *m, const key_t lo, const key_t hi, key_t *arr, const size_t n) {
+  // [lo, hi] 구간의 key를 최대 n개까지 arr에 기록하고 기록한 개수를 반환
+  if (m->tree != NULL) return rbtree_range(m->tree, lo, hi, arr, n);
+
+  const size_t count = m->header->count;
+  size_t j = 0;
+
+  for (size_t i = rbtree_mapped_lower_index(m, lo); j < n && i < count && m->nodes[i].key <= hi; i++)
+  {
+    arr[j++] = m->nodes[i].key;
+  }
+  return j;
+}
+
+rbtree *rbtree_mapped_tree(rbtree_mapped *m) {
+  // 처음 쓰기가 일어날 때 mapping의 key로 트리를 만들고 mapping은 해제한다
+  if (m->tree != NULL) return m->tree;
+
+  const size_t n = m->header->count;
+  key_t *keys = (key_t *)malloc((n > 0 ? n : 1) * sizeof(key_t));
+  if (keys == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < n; i++) keys[i] = m->nodes[i].key;
+  m->tree = rbtree_from_sorted_array(keys, n);
+  free(keys);
+
+  munmap(m->map, m->map_len);
+  m->map = NULL;
+  m->header = NULL;
+  m->nodes = NULL;
+  return m->tree;
+}
+
+rbtree *rbtree_mapped_detach(rbtree_mapped *m) {
+  rbtree *t = rbtree_mapped_tree(m);
+
+  m->tree = NULL;
+  delete_rbtree_mapped(m);
+  return t;
+}
+
+node_t *rbtree_mapped_insert(rbtree_mapped *m, const key_t key) {
+  return rbtree_insert(rbtree_mapped_tree(m), key);
+}
+
+int rbtree_mapped_erase(rbtree_mapped *m, const key_t key) {
+  // 지울 key가 없으면 트리로 옮기지 않는다
+  if (m->tree == NULL && !rbtree_mapped_contains(m, key)) return 0;
+
+  rbtree *t = rbtree_mapped_tree(m);
+  node_t *p = rbtree_find(t, key);
+  if (p != NULL) rbtree_erase(t, p);
+  return p != NULL;
+}
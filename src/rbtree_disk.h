@@ -0,0 +1,71 @@
+#ifndef _RBTREE_DISK_H_
+#define _RBTREE_DISK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rbtree.h"
+
+// 트리를 파일로 저장하고 mmap으로 바로 읽는 on-disk 형식.
+//
+//   [rbtree_disk_header][rbtree_disk_node x count]
+//
+// node는 in-order 순서로 저장하고 자식은 포인터 대신 node 배열의 index로 가리킨다.
+// 따라서 파일을 mapping한 채로 트리를 따라 내려가 검색할 수 있고, 범위 질의는 배열을 순서대로 읽으면 된다.
+// 정수는 저장한 machine의 byte order를 따르며, 읽을 때 magic/version/node 크기와 checksum을 확인한다.
+
+#define RBTREE_DISK_MAGIC "RBTREEDB"
+#define RBTREE_DISK_VERSION 1
+#define RBTREE_DISK_NIL UINT32_MAX
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t node_size;  // sizeof(rbtree_disk_node), key_t가 다른 build의 파일을 거부
+  uint64_t count;
+  uint32_t root;
+  uint32_t reserved;
+  uint64_t checksum;   // node 영역 전체의 checksum
+} rbtree_disk_header;
+
+typedef struct {
+  uint32_t left, right;
+  key_t key;
+  uint32_t color;
+} rbtree_disk_node;
+
+// mapping된 파일. 처음 쓰기가 일어나면 mutable한 rbtree로 복사하고(copy-on-write)
+// 그 뒤로는 모든 연산이 tree에서 처리된다. 원래 파일은 바뀌지 않는다.
+typedef struct {
+  void *map;
+  size_t map_len;
+  const rbtree_disk_header *header;
+  const rbtree_disk_node *nodes;
+
+  rbtree *tree;
+} rbtree_mapped;
+
+// 성공하면 0, 실패하면 -1을 반환하고 errno를 남긴다. 같은 디렉터리의 임시 파일에 쓰고 fsync 한 뒤 rename 하고
+// 디렉터리도 fsync 한다. 디렉터리 fsync만 실패하면 파일은 바뀌었지만 내구성은 보장되지 않은 채 -1을 반환한다.
+// counted 트리는 저장할 수 없다 (EINVAL).
+int rbtree_save(const rbtree *, const char *);
+// path를 만들거나 rename으로 바꾼 것이 전원이 꺼져도 남도록 path가 들어 있는 디렉터리를 fsync 한다.
+// 성공하면 0, 실패하면 -1을 반환하고 errno를 남긴다.
+int rbtree_disk_sync_dir(const char *);
+// 파일이 없거나 형식/checksum이 맞지 않으면 NULL.
+rbtree_mapped *rbtree_load_mmap(const char *);
+void delete_rbtree_mapped(rbtree_mapped *);
+
+size_t rbtree_mapped_size(const rbtree_mapped *);
+int rbtree_mapped_contains(const rbtree_mapped *, const key_t);
+int rbtree_mapped_lower_bound(const rbtree_mapped *, const key_t, key_t *);
+size_t rbtree_mapped_range(const rbtree_mapped *, const key_t, const key_t, key_t *, const size_t);
+
+// 쓰기 연산. 필요하면 먼저 mutable한 트리로 옮긴다.
+rbtree *rbtree_mapped_tree(rbtree_mapped *);
+// mutable한 트리로 옮긴 뒤 트리를 넘겨주고 m은 해제한다.
+rbtree *rbtree_mapped_detach(rbtree_mapped *);
+node_t *rbtree_mapped_insert(rbtree_mapped *, const key_t);
+int rbtree_mapped_erase(rbtree_mapped *, const key_t);
+
+#endif  // _RBTREE_DISK_H_
@@ -0,0 +1,317 @@
+#ifndef _RBTREE_GENERIC_H_
+#define _RBTREE_GENERIC_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rbtree.h"
+
+// key/value 타입과 비교 함수를 컴파일 타임에 지정하는 header-only RB tree.
+//
+//   #define INT_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+//   RBTREE_DEFINE(itree, int, double, INT_CMP)
+//
+// 위 선언은 itree, itree_node 타입과 itree_new, itree_delete, itree_insert,
+// itree_find, itree_erase, itree_min, itree_max, itree_next, itree_prev,
+// itree_size 함수를 만든다. cmp(a, b)는 a < b, a == b, a > b 일 때 각각
+// 음수, 0, 양수를 반환해야 하며 함수가 아닌 매크로나 inline 함수여도 된다.
+// 모든 함수가 static inline 이므로 비교 연산은 호출 위치에 inline 된다.
+// value는 node 안에 그대로 저장되며, multiset 의미는 rbtree.h와 같다.
+
+#define RBTREE_CMP_SCALAR(a, b) (((a) > (b)) - ((a) < (b)))
+
+#define RBTREE_DEFINE(name, key_type, value_type, cmp)                          \
+                                                                                \
+typedef struct name##_node {                                                    \
+  struct name##_node *parent, *left, *right;                                    \
+  color_t color;                                                                \
+  key_type key;                                                                 \
+  value_type value;                                                             \
+} name##_node;                                                                  \
+                                                                                \
+typedef struct {                                                                \
+  name##_node *root;                                                            \
+  name##_node nil;  /* sentinel, 트리 구조체 안에 포함 */                        \
+  size_t size;                                                                  \
+} name;                                                                         \
+                                                                                \
+static inline name *name##_new(void) {                                          \
+  name *t = (name *)calloc(1, sizeof(name));                                    \
+  if (t == NULL) {                                                              \
+    fprintf(stderr, "Memory allocation failed\n");                              \
+    exit(EXIT_FAILURE);                                                         \
+  }                                                                             \
+  t->nil.color = RBTREE_BLACK;                                                  \
+  t->root = &t->nil;                                                            \
+  return t;                                                                     \
+}                                                                               \
+                                                                                \
+static inline void name##_delete(name *t) {                                     \
+  if (t == NULL) return;                                                        \
+  name##_node *nil = &t->nil;                                                   \
+  name##_node *p = t->root;                                                     \
+  /* parent 포인터를 이용한 후위 순회로 스택 없이 해제 */                       \
+  while (p != nil) {                                                            \
+    if (p->left != nil)       p = p->left;                                      \
+    else if (p->right != nil) p = p->right;                                     \
+    else {                                                                      \
+      name##_node *parent = p->parent;                                          \
+      if (parent != nil) {                                                      \
+        if (parent->left == p) parent->left = nil;                              \
+        else                   parent->right = nil;                             \
+      }                                                                         \
+      free(p);                                                                  \
+      p = parent;                                                               \
+    }                                                                           \
+  }                                                                             \
+  free(t);                                                                      \
+}                                                                               \
+                                                                                \
+static inline size_t name##_size(const name *t) { return t->size; }             \
+                                                                                \
+static inline void name##_left_rotate(name *t, name##_node *x) {                \
+  name##_node *nil = &t->nil;                                                   \
+  name##_node *y = x->right;                                                    \
+  x->right = y->left;                                                           \
+  if (y->left != nil) y->left->parent = x;                                      \
+  y->parent = x->parent;                                                        \
+  if (x->parent == nil)              t->root = y;                               \
+  else if (x == x->parent->left)     x->parent->left = y;                       \
+  else                               x->parent->right = y;                      \
+  y->left = x;                                                                  \
+  x->parent = y;                                                                \
+}                                                                               \
+                                                                                \
+static inline void name##_right_rotate(name *t, name##_node *x) {               \
+  name##_node *nil = &t->nil;                                                   \
+  name##_node *y = x->left;                                                     \
+  x->left = y->right;                                                           \
+  if (y->right != nil) y->right->parent = x;                                    \
+  y->parent = x->parent;                                                        \
+  if (x->parent == nil)              t->root = y;                               \
+  else if (x == x->parent->right)    x->parent->right = y;                      \
+  else                               x->parent->left = y;                       \
+  y->right = x;                                                                 \
+  x->parent = y;                                                                \
+}                                                                               \
+                                                                                \
+static inline void name##_insert_fixup(name *t, name##_node *z) {               \
+  while (z->parent->color == RBTREE_RED) {                                      \
+    name##_node *g = z->parent->parent;                                         \
+    if (z->parent == g->left) {                                                 \
+      name##_node *uncle = g->right;                                            \
+      if (uncle->color == RBTREE_RED) {                                         \
+        z->parent->color = RBTREE_BLACK;                                        \
+        uncle->color = RBTREE_BLACK;                                            \
+        g->color = RBTREE_RED;                                                  \
+        z = g;                                                                  \
+      } else {                                                                  \
+        if (z == z->parent->right) {                                            \
+          z = z->parent;                                                        \
+          name##_left_rotate(t, z);                                             \
+        }                                                                       \
+        z->parent->color = RBTREE_BLACK;                                        \
+        z->parent->parent->color = RBTREE_RED;                                  \
+        name##_right_rotate(t, z->parent->parent);                              \
+      }                                                                         \
+    } else {                                                                    \
+      name##_node *uncle = g->left;                                             \
+      if (uncle->color == RBTREE_RED) {                                         \
+        z->parent->color = RBTREE_BLACK;                                        \
+        uncle->color = RBTREE_BLACK;                                            \
+        g->color = RBTREE_RED;                                                  \
+        z = g;                                                                  \
+      } else {                                                                  \
+        if (z == z->parent->left) {                                             \
+          z = z->parent;                                                        \
+          name##_right_rotate(t, z);                                            \
+        }                                                                       \
+        z->parent->color = RBTREE_BLACK;                                        \
+        z->parent->parent->color = RBTREE_RED;                                  \
+        name##_left_rotate(t, z->parent->parent);                               \
+      }                                                                         \
+    }                                                                           \
+  }                                                                             \
+  t->root->color = RBTREE_BLACK;                                                \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_insert(name *t, key_type key,                 \
+                                         value_type value) {                    \
+  name##_node *nil = &t->nil;                                                   \
+  name##_node *parent = nil;                                                    \
+  name##_node *ptr = t->root;                                                   \
+  name##_node *z = (name##_node *)malloc(sizeof(name##_node));                  \
+  if (z == NULL) {                                                              \
+    fprintf(stderr, "Memory allocation failed\n");                              \
+    exit(EXIT_FAILURE);                                                         \
+  }                                                                             \
+  z->key = key;                                                                 \
+  z->value = value;                                                             \
+  while (ptr != nil) {                                                          \
+    parent = ptr;                                                               \
+    if (cmp(z->key, ptr->key) < 0) ptr = ptr->left;                             \
+    else                           ptr = ptr->right;                            \
+  }                                                                             \
+  z->parent = parent;                                                           \
+  if (parent == nil)                        t->root = z;                        \
+  else if (cmp(z->key, parent->key) < 0)    parent->left = z;                   \
+  else                                      parent->right = z;                  \
+  z->left = nil;                                                                \
+  z->right = nil;                                                               \
+  z->color = RBTREE_RED;                                                        \
+  t->size++;                                                                    \
+  name##_insert_fixup(t, z);                                                    \
+  return z;                                                                     \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_find(const name *t, key_type key) {           \
+  const name##_node *nil = &t->nil;                                             \
+  name##_node *ptr = t->root;                                                   \
+  while (ptr != nil) {                                                          \
+    int c = cmp(key, ptr->key);                                                 \
+    if (c < 0)      ptr = ptr->left;                                            \
+    else if (c > 0) ptr = ptr->right;                                           \
+    else            return ptr;                                                 \
+  }                                                                             \
+  return NULL;                                                                  \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_subtree_min(const name *t, name##_node *p) {  \
+  while (p->left != &t->nil) p = p->left;                                       \
+  return p;                                                                     \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_subtree_max(const name *t, name##_node *p) {  \
+  while (p->right != &t->nil) p = p->right;                                     \
+  return p;                                                                     \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_min(const name *t) {                          \
+  return t->root == &t->nil ? NULL : name##_subtree_min(t, t->root);            \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_max(const name *t) {                          \
+  return t->root == &t->nil ? NULL : name##_subtree_max(t, t->root);            \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_next(const name *t, name##_node *x) {         \
+  const name##_node *nil = &t->nil;                                             \
+  if (x->right != nil) return name##_subtree_min(t, x->right);                  \
+  name##_node *y = x->parent;                                                   \
+  while (y != nil && x == y->right) {                                           \
+    x = y;                                                                      \
+    y = y->parent;                                                              \
+  }                                                                             \
+  return y == nil ? NULL : y;                                                   \
+}                                                                               \
+                                                                                \
+static inline name##_node *name##_prev(const name *t, name##_node *x) {         \
+  const name##_node *nil = &t->nil;                                             \
+  if (x->left != nil) return name##_subtree_max(t, x->left);                    \
+  name##_node *y = x->parent;                                                   \
+  while (y != nil && x == y->left) {                                            \
+    x = y;                                                                      \
+    y = y->parent;                                                              \
+  }                                                                             \
+  return y == nil ? NULL : y;                                                   \
+}                                                                               \
+                                                                                \
+static inline void name##_transplant(name *t, name##_node *u,                   \
+                                      name##_node *v) {                         \
+  if (u->parent == &t->nil)      t->root = v;                                   \
+  else if (u == u->parent->left) u->parent->left = v;                           \
+  else                           u->parent->right = v;                          \
+  v->parent = u->parent;                                                        \
+}                                                                               \
+                                                                                \
+static inline void name##_delete_fixup(name *t, name##_node *x) {               \
+  while (x != t->root && x->color == RBTREE_BLACK) {                            \
+    if (x == x->parent->left) {                                                 \
+      name##_node *w = x->parent->right;                                        \
+      if (w->color == RBTREE_RED) {                                             \
+        w->color = RBTREE_BLACK;                                                \
+        x->parent->color = RBTREE_RED;                                          \
+        name##_left_rotate(t, x->parent);                                       \
+        w = x->parent->right;                                                   \
+      }                                                                         \
+      if (w->left->color == RBTREE_BLACK &&                                     \
+          w->right->color == RBTREE_BLACK) {                                    \
+        w->color = RBTREE_RED;                                                  \
+        x = x->parent;                                                          \
+      } else {                                                                  \
+        if (w->right->color == RBTREE_BLACK) {                                  \
+          w->left->color = RBTREE_BLACK;                                        \
+          w->color = RBTREE_RED;                                                \
+          name##_right_rotate(t, w);                                            \
+          w = x->parent->right;                                                 \
+        }                                                                       \
+        w->color = x->parent->color;                                            \
+        x->parent->color = RBTREE_BLACK;                                        \
+        w->right->color = RBTREE_BLACK;                                         \
+        name##_left_rotate(t, x->parent);                                       \
+        x = t->root;                                                            \
+      }                                                                         \
+    } else {                                                                    \
+      name##_node *w = x->parent->left;                                         \
+      if (w->color == RBTREE_RED) {                                             \
+        w->color = RBTREE_BLACK;                                                \
+        x->parent->color = RBTREE_RED;                                          \
+        name##_right_rotate(t, x->parent);                                      \
+        w = x->parent->left;                                                    \
+      }                                                                         \
+      if (w->right->color == RBTREE_BLACK &&                                    \
+          w->left->color == RBTREE_BLACK) {                                     \
+        w->color = RBTREE_RED;                                                  \
+        x = x->parent;                                                          \
+      } else {                                                                  \
+        if (w->left->color == RBTREE_BLACK) {                                   \
+          w->right->color = RBTREE_BLACK;                                       \
+          w->color = RBTREE_RED;                                                \
+          name##_left_rotate(t, w);                                             \
+          w = x->parent->left;                                                  \
+        }                                                                       \
+        w->color = x->parent->color;                                            \
+        x->parent->color = RBTREE_BLACK;                                        \
+        w->left->color = RBTREE_BLACK;                                          \
+        name##_right_rotate(t, x->parent);                                      \
+        x = t->root;                                                            \
+      }                                                                         \
+    }                                                                           \
+  }                                                                             \
+  x->color = RBTREE_BLACK;                                                      \
+}                                                                               \
+                                                                                \
+static inline int name##_erase(name *t, name##_node *z) {                       \
+  name##_node *nil = &t->nil;                                                   \
+  name##_node *y = z;                                                           \
+  color_t y_original_color = y->color;                                          \
+  name##_node *x;                                                               \
+  if (z->left == nil) {                                                         \
+    x = z->right;                                                               \
+    name##_transplant(t, z, z->right);                                          \
+  } else if (z->right == nil) {                                                 \
+    x = z->left;                                                                \
+    name##_transplant(t, z, z->left);                                           \
+  } else {                                                                      \
+    y = name##_subtree_min(t, z->right);                                        \
+    y_original_color = y->color;                                                \
+    x = y->right;                                                               \
+    if (y->parent == z) {                                                       \
+      x->parent = y;                                                            \
+    } else {                                                                    \
+      name##_transplant(t, y, y->right);                                        \
+      y->right = z->right;                                                      \
+      y->right->parent = y;                                                     \
+    }                                                                           \
+    name##_transplant(t, z, y);                                                 \
+    y->left = z->left;                                                          \
+    y->left->parent = y;                                                        \
+    y->color = z->color;                                                        \
+  }                                                                             \
+  if (y_original_color == RBTREE_BLACK) name##_delete_fixup(t, x);              \
+  free(z);                                                                      \
+  t->size--;                                                                    \
+  return 0;                                                                     \
+}
+
+#endif  // _RBTREE_GENERIC_H_
@@ -0,0 +1,360 @@
+#include "rbtree_interval.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// 자식의 max_hi로 x의 max_hi를 다시 계산한다
+static void ivnode_update(const rbtree_interval *t, ivnode_t *x)
+{
+  key_t m = x->hi;
+
+  if (x->left != t->nil && x->left->max_hi > m)   m = x->left->max_hi;
+  if (x->right != t->nil && x->right->max_hi > m) m = x->right->max_hi;
+  x->max_hi = m;
+}
+
+rbtree_interval *new_rbtree_interval(void) {
+  rbtree_interval *t = (rbtree_interval *)calloc(1, sizeof(rbtree_interval));
+  ivnode_t *nil = (ivnode_t *)calloc(1, sizeof(ivnode_t));
+
+  if (t == NULL || nil == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  nil->color = RBTREE_BLACK;
+  t->nil = nil;
+  t->root = nil;
+  return t;
+}
+
+void delete_rbtree_interval(rbtree_interval *t) {
+  if (t == NULL) return;
+
+  // parent 포인터를 이용한 후위 순회로 스택 없이 해제
+  ivnode_t *nil = t->nil;
+  ivnode_t *p = t->root;
+  while (p != nil)
+  {
+    if (p->left != nil)        p = p->left;
+    else if (p->right != nil)  p = p->right;
+    else
+    {
+      ivnode_t *parent = p->parent;
+      if (parent != nil)
+      {
+        if (parent->left == p)  parent->left = nil;
+        else                    parent->right = nil;
+      }
+      free(p);
+      p = parent;
+    }
+  }
+  free(nil);
+  free(t);
+}
+
+size_t rbtree_interval_size(const rbtree_interval *t) {
+  return t->size;
+}
+
+// 회전 후에는 내려간 x를 먼저, 올라온 y를 나중에 갱신한다
+static void ivnode_left_rotate(rbtree_interval *t, ivnode_t *x)
+{
+  ivnode_t *y = x->right;
+
+  x->right = y->left;
+  if (y->left != t->nil) y->left->parent = x;
+  y->parent = x->parent;
+  if (x->parent == t->nil)            t->root = y;
+  else if (x == x->parent->left)      x->parent->left = y;
+  else                                x->parent->right = y;
+  y->left = x;
+  x->parent = y;
+
+  ivnode_update(t, x);
+  ivnode_update(t, y);
+}
+
+static void ivnode_right_rotate(rbtree_interval *t, ivnode_t *x)
+{
+  ivnode_t *y = x->left;
+
+  x->left = y->right;
+  if (y->right != t->nil) y->right->parent = x;
+  y->parent = x->parent;
+  if (x->parent == t->nil)            t->root = y;
+  else if (x == x->parent->right)     x->parent->right = y;
+  else                                x->parent->left = y;
+  y->right = x;
+  x->parent = y;
+
+  ivnode_update(t, x);
+  ivnode_update(t, y);
+}
+
+// fixup은 색만 바꾸거나 회전하므로 max_hi는 회전에서만 갱신하면 된다
+static void ivnode_insert_fixup(rbtree_interval *t, ivnode_t *z)
+{
+  while (z->parent->color == RBTREE_RED)
+  {
+    ivnode_t *g = z->parent->parent;
+    if (z->parent == g->left)
+    {
+      ivnode_t *uncle = g->right;
+      if (uncle->color == RBTREE_RED)
+      {
+        z->parent->color = RBTREE_BLACK;
+        uncle->color = RBTREE_BLACK;
+        g->color = RBTREE_RED;
+        z = g;
+        continue;
+      }
+      if (z == z->parent->right)
+      {
+        z = z->parent;
+        ivnode_left_rotate(t, z);
+      }
+      z->parent->color = RBTREE_BLACK;
+      z->parent->parent->color = RBTREE_RED;
+      ivnode_right_rotate(t, z->parent->parent);
+    }
+    else
+    {
+      ivnode_t *uncle = g->left;
+      if (uncle->color == RBTREE_RED)
+      {
+        z->parent->color = RBTREE_BLACK;
+        uncle->color = RBTREE_BLACK;
+        g->color = RBTREE_RED;
+        z = g;
+        continue;
+      }
+      if (z == z->parent->left)
+      {
+        z = z->parent;
+        ivnode_right_rotate(t, z);
+      }
+      z->parent->color = RBTREE_BLACK;
+      z->parent->parent->color = RBTREE_RED;
+      ivnode_left_rotate(t, z->parent->parent);
+    }
+  }
+  t->root->color = RBTREE_BLACK;
+}
+
+ivnode_t *rbtree_interval_insert(rbtree_interval *t, const key_t lo, const key_t hi) {
+  if (lo > hi) return NULL;
+
+  ivnode_t *z = (ivnode_t *)malloc(sizeof(ivnode_t));
+  if (z == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  z->lo = lo;
+  z->hi = hi;
+  z->max_hi = hi;
+  z->color = RBTREE_RED;
+  z->left = t->nil;
+  z->right = t->nil;
+
+  ivnode_t *parent = t->nil;
+  for (ivnode_t *p = t->root; p != t->nil;)
+  {
+    parent = p;
+    if (p->max_hi < hi) p->max_hi = hi;                  // 경로 위의 max_hi 갱신
+    p = (lo < p->lo) ? p->left : p->right;
+  }
+
+  z->parent = parent;
+  if (parent == t->nil)     t->root = z;
+  else if (lo < parent->lo) parent->left = z;
+  else                      parent->right = z;
+
+  ivnode_insert_fixup(t, z);
+  t->size++;
+  return z;
+}
+
+ivnode_t *rbtree_interval_find(const rbtree_interval *t, const key_t lo, const key_t hi) {
+  // lo가 같은 node는 양쪽 서브트리에 있을 수 있으므로 lo 이상인 첫 node부터 차례로 본다
+  ivnode_t *p = t->root, *found = t->nil;
+
+  while (p != t->nil)
+  {
+    if (p->lo < lo)
+    {
+      p = p->right;
+    }
+    else
+    {
+      found = p;
+      p = p->left;
+    }
+  }
+
+  for (p = found; p != t->nil && p->lo == lo;)
+  {
+    if (p->hi == hi) return p;
+    if (p->right != t->nil)
+    {
+      for (p = p->right; p->left != t->nil;) p = p->left;
+    }
+    else
+    {
+      while (p->parent != t->nil && p == p->parent->right) p = p->parent;
+      p = p->parent;
+    }
+  }
+  return NULL;
+}
+
+static void ivnode_transplant(rbtree_interval *t, ivnode_t *u, ivnode_t *v)
+{
+  if (u->parent == t->nil)        t->root = v;
+  else if (u == u->parent->left)  u->parent->left = v;
+  else                            u->parent->right = v;
+  v->parent = u->parent;
+}
+
+static void ivnode_delete_fixup(rbtree_interval *t, ivnode_t *x)
+{
+  while (x != t->root && x->color == RBTREE_BLACK)
+  {
+    if (x == x->parent->left)
+    {
+      ivnode_t *w = x->parent->right;
+      if (w->color == RBTREE_RED)
+      {
+        w->color = RBTREE_BLACK;
+        x->parent->color = RBTREE_RED;
+        ivnode_left_rotate(t, x->parent);
+        w = x->parent->right;
+      }
+      if (w->left->color == RBTREE_BLACK && w->right->color == RBTREE_BLACK)
+      {
+        w->color = RBTREE_RED;
+        x = x->parent;
+        continue;
+      }
+      if (w->right->color == RBTREE_BLACK)
+      {
+        w->left->color = RBTREE_BLACK;
+        w->color = RBTREE_RED;
+        ivnode_right_rotate(t, w);
+        w = x->parent->right;
+      }
+      w->color = x->parent->color;
+      x->parent->color = RBTREE_BLACK;
+      w->right->color = RBTREE_BLACK;
+      ivnode_left_rotate(t, x->parent);
+      x = t->root;
+    }
+    else
+    {
+      ivnode_t *w = x->parent->left;
+      if (w->color == RBTREE_RED)
+      {
+        w->color = RBTREE_BLACK;
+        x->parent->color = RBTREE_RED;
+        ivnode_right_rotate(t, x->parent);
+        w = x->parent->left;
+      }
+      if (w->right->color == RBTREE_BLACK && w->left->color == RBTREE_BLACK)
+      {
+        w->color = RBTREE_RED;
+        x = x->parent;
+        continue;
+      }
+      if (w->left->color == RBTREE_BLACK)
+      {
+        w->right->color = RBTREE_BLACK;
+        w->color = RBTREE_RED;
+        ivnode_left_rotate(t, w);
+        w = x->parent->left;
+      }
+      w->color = x->parent->color;
+      x->parent->color = RBTREE_BLACK;
+      w->left->color = RBTREE_BLACK;
+      ivnode_right_rotate(t, x->parent);
+      x = t->root;
+    }
+  }
+  x->color = RBTREE_BLACK;
+}
+
+int rbtree_interval_erase(rbtree_interval *t, ivnode_t *z) {
+  ivnode_t *y = z, *x, *from;
+  color_t y_original_color = y->color;
+
+  if (z->left == t->nil)
+  {
+    x = z->right;
+    from = z->parent;
+    ivnode_transplant(t, z, z->right);
+  }
+  else if (z->right == t->nil)
+  {
+    x = z->left;
+    from = z->parent;
+    ivnode_transplant(t, z, z->left);
+  }
+  else
+  {
+    for (y = z->right; y->left != t->nil;) y = y->left;
+    y_original_color = y->color;
+    x = y->right;
+    if (y->parent == z)
+    {
+      x->parent = y;
+      from = y;
+    }
+    else
+    {
+      from = y->parent;
+      ivnode_transplant(t, y, y->right);
+      y->right = z->right;
+      y->right->parent = y;
+    }
+    ivnode_transplant(t, z, y);
+    y->left = z->left;
+    y->left->parent = y;
+    y->color = z->color;
+  }
+
+  // 구조가 바뀐 가장 아래 node부터 루트까지 max_hi를 다시 계산한 뒤 fixup의 회전에 맡긴다
+  for (ivnode_t *p = from; p != t->nil; p = p->parent) ivnode_update(t, p);
+  if (y_original_color == RBTREE_BLACK) ivnode_delete_fixup(t, x);
+
+  free(z);
+  t->size--;
+  return 0;
+}
+
+// x 서브트리에서 [a, b]와 겹치는 구간을 lo 순서로 방문한다. 중단되면 1.
+// max_hi < a인 서브트리와 lo > b인 node의 오른쪽은 볼 필요가 없다.
+static int ivnode_overlaps(const rbtree_interval *t, ivnode_t *x, const key_t a, const key_t b,
+                           rbtree_interval_visit_fn fn, void *arg, size_t *count)
+{
+  while (x != t->nil && x->max_hi >= a)
+  {
+    if (ivnode_overlaps(t, x->left, a, b, fn, arg, count)) return 1;
+    if (x->lo > b) return 0;
+    if (x->hi >= a)
+    {
+      (*count)++;
+      if (fn(x, arg) != 0) return 1;
+    }
+    x = x->right;
+  }
+  return 0;
+}
+
+size_t rbtree_interval_overlaps(const rbtree_interval *t, const key_t a, const key_t b,
+                                rbtree_interval_visit_fn fn, void *arg) {
+  size_t count = 0;
+
+  if (a <= b) ivnode_overlaps(t, t->root, a, b, fn, arg, &count);
+  return count;
+}
@@ -0,0 +1,42 @@
+#ifndef _RBTREE_INTERVAL_H_
+#define _RBTREE_INTERVAL_H_
+
+#include <stddef.h>
+
+#include "rbtree.h"
+
+// 닫힌 구간 [lo, hi]를 저장하는 interval tree.
+// lo를 key로 하는 RB 트리에 서브트리 안 hi의 최댓값(max_hi)을 덧붙이고, 삽입 경로, 삭제 후 경로,
+// 회전에서 이 값을 갱신한다. 겹치는 구간을 찾을 때 max_hi가 a보다 작은 서브트리는 내려가지 않는다.
+// 같은 구간을 여러 번 넣을 수 있다(multiset).
+
+typedef struct ivnode_t {
+  color_t color;
+  key_t lo, hi;
+  key_t max_hi;  // 이 node를 루트로 하는 서브트리에서 hi의 최댓값
+  struct ivnode_t *parent, *left, *right;
+} ivnode_t;
+
+typedef struct {
+  ivnode_t *root;
+  ivnode_t *nil;
+  size_t size;
+} rbtree_interval;
+
+typedef int (*rbtree_interval_visit_fn)(ivnode_t *, void *);
+
+rbtree_interval *new_rbtree_interval(void);
+void delete_rbtree_interval(rbtree_interval *);
+
+// lo > hi이면 넣지 않고 NULL.
+ivnode_t *rbtree_interval_insert(rbtree_interval *, const key_t, const key_t);
+// [lo, hi]와 똑같은 구간 하나를 찾는다. 없으면 NULL.
+ivnode_t *rbtree_interval_find(const rbtree_interval *, const key_t, const key_t);
+int rbtree_interval_erase(rbtree_interval *, ivnode_t *);
+size_t rbtree_interval_size(const rbtree_interval *);
+
+// [a, b]와 겹치는 구간을 lo 순서로 방문하고 방문한 수를 반환한다. fn이 0이 아닌 값을 반환하면 중단.
+// 내려가는 node는 a와 b의 탐색 경로와 겹치는 구간의 조상들뿐이다.
+size_t rbtree_interval_overlaps(const rbtree_interval *, const key_t, const key_t, rbtree_interval_visit_fn, void *);
+
+#endif  // _RBTREE_INTERVAL_H_
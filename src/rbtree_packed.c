@@ -0,0 +1,245 @@
+#include "rbtree_packed.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+_Static_assert(_Alignof(pnode_t) >= 2, "pnode_t needs a free low pointer bit for the color");
+
+// ---------------------------------------------------------------------------
+// 포인터 링크 + color bit
+
+#define PK(fn) prbtree_##fn
+#define PK_TREE prbtree
+#define PK_LINK pnode_t *
+#define PK_NULL NULL
+#define PK_ROOT(t) ((t)->root)
+#define PK_LEFT(t, x) ((x)->left)
+#define PK_RIGHT(t, x) ((x)->right)
+#define PK_KEY(t, x) ((x)->key)
+#define PK_PARENT(t, x) PRBTREE_PARENT(x)
+#define PK_SET_PARENT(t, x, p) \
+  ((x)->parent_color = (uintptr_t)(p) | ((x)->parent_color & 1))
+#define PK_COLOR(t, x) PRBTREE_COLOR(x)
+#define PK_SET_COLOR(t, x, c) \
+  ((x)->parent_color = ((x)->parent_color & ~(uintptr_t)1) | (uintptr_t)(c))
+
+#include "rbtree_packed_impl.h"
+
+#undef PK
+#undef PK_TREE
+#undef PK_LINK
+#undef PK_NULL
+#undef PK_ROOT
+#undef PK_LEFT
+#undef PK_RIGHT
+#undef PK_KEY
+#undef PK_PARENT
+#undef PK_SET_PARENT
+#undef PK_COLOR
+#undef PK_SET_COLOR
+
+#define PRBTREE_CHUNK_NODES 1024
+
+// rbtree의 slab과 같은 방식으로 node를 묶어서 할당한다.
+struct prbtree_chunk {
+  prbtree_chunk *next;
+  pnode_t nodes[PRBTREE_CHUNK_NODES];
+};
+
+prbtree *new_prbtree(void) {
+  prbtree *t = (prbtree *)calloc(1, sizeof(prbtree));
+
+  if (t == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return t;
+}
+
+void delete_prbtree(prbtree *t) {
+  if (t == NULL) return;
+
+  prbtree_chunk *chunk = t->chunks;
+  while (chunk != NULL)
+  {
+    prbtree_chunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(t);
+}
+
+static pnode_t *prbtree_node_alloc(prbtree *t)
+{
+  pnode_t *n = t->free_list;
+
+  if (n != NULL)
+  {
+    t->free_list = n->left;                              // free list는 left 포인터로 연결
+    return n;
+  }
+  if (t->chunks == NULL || t->chunk_used == PRBTREE_CHUNK_NODES)
+  {
+    prbtree_chunk *chunk = (prbtree_chunk *)malloc(sizeof(prbtree_chunk));
+    if (chunk == NULL)
+    {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    chunk->next = t->chunks;
+    t->chunks = chunk;
+    t->chunk_used = 0;
+  }
+  return &t->chunks->nodes[t->chunk_used++];
+}
+
+pnode_t *prbtree_insert(prbtree *t, const key_t key) {
+  pnode_t *z = prbtree_node_alloc(t);
+
+  z->key = key;
+  z->parent_color = 0;
+  prbtree_link(t, z);
+  t->size++;
+  return z;
+}
+
+pnode_t *prbtree_find(const prbtree *t, const key_t key) {
+  return prbtree_lookup(t, key);
+}
+
+pnode_t *prbtree_min(const prbtree *t) {
+  return prbtree_subtree_min(t, t->root);
+}
+
+pnode_t *prbtree_max(const prbtree *t) {
+  return prbtree_subtree_max(t, t->root);
+}
+
+pnode_t *prbtree_next(const prbtree *t, const pnode_t *p) {
+  return prbtree_successor(t, (pnode_t *)p);
+}
+
+int prbtree_erase(prbtree *t, pnode_t *z) {
+  prbtree_unlink(t, z);
+  z->left = t->free_list;
+  t->free_list = z;
+  t->size--;
+  return 0;
+}
+
+int prbtree_to_array(const prbtree *t, key_t *arr, const size_t n) {
+  return prbtree_export(t, arr, n);
+}
+
+// ---------------------------------------------------------------------------
+// 32bit index 링크 + color bit
+
+#define IN(t, i) ((t)->nodes[i])
+
+#define PK(fn) irbtree_##fn
+#define PK_TREE irbtree
+#define PK_LINK inode_id
+#define PK_NULL IRBTREE_NIL
+#define PK_ROOT(t) ((t)->root)
+#define PK_LEFT(t, x) (IN(t, x).left)
+#define PK_RIGHT(t, x) (IN(t, x).right)
+#define PK_KEY(t, x) (IN(t, x).key)
+#define PK_PARENT(t, x) IRBTREE_PARENT(t, x)
+#define PK_SET_PARENT(t, x, p) \
+  (IN(t, x).parent_color = ((uint32_t)(p) << 1) | (IN(t, x).parent_color & 1))
+#define PK_COLOR(t, x) IRBTREE_COLOR(t, x)
+#define PK_SET_COLOR(t, x, c) \
+  (IN(t, x).parent_color = (IN(t, x).parent_color & ~(uint32_t)1) | (uint32_t)(c))
+
+#include "rbtree_packed_impl.h"
+
+#define IRBTREE_INIT_CAP 64
+
+irbtree *new_irbtree(void) {
+  irbtree *t = (irbtree *)calloc(1, sizeof(irbtree));
+
+  if (t == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  t->used = 1;                                           // 0번 index는 NULL 역할
+  return t;
+}
+
+void delete_irbtree(irbtree *t) {
+  if (t == NULL) return;
+
+  free(t->nodes);
+  free(t);
+}
+
+static inode_id irbtree_node_alloc(irbtree *t)
+{
+  inode_id id = t->free_list;
+
+  if (id != IRBTREE_NIL)
+  {
+    t->free_list = IN(t, id).left;                       // free list는 left index로 연결
+    return id;
+  }
+  if (t->used >= t->cap)
+  {
+    if (t->cap >= IRBTREE_MAX_NODES)
+    {
+      fprintf(stderr, "irbtree: too many nodes\n");
+      exit(EXIT_FAILURE);
+    }
+    uint64_t cap = (t->cap == 0) ? IRBTREE_INIT_CAP : (uint64_t)t->cap * 2;
+    if (cap > IRBTREE_MAX_NODES) cap = IRBTREE_MAX_NODES;
+
+    inode_t *nodes = (inode_t *)realloc(t->nodes, cap * sizeof(inode_t));
+    if (nodes == NULL)
+    {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    t->nodes = nodes;
+    t->cap = (uint32_t)cap;
+  }
+  return t->used++;
+}
+
+inode_id irbtree_insert(irbtree *t, const key_t key) {
+  inode_id z = irbtree_node_alloc(t);
+
+  IN(t, z).key = key;
+  IN(t, z).parent_color = 0;
+  irbtree_link(t, z);
+  t->size++;
+  return z;
+}
+
+inode_id irbtree_find(const irbtree *t, const key_t key) {
+  return irbtree_lookup(t, key);
+}
+
+inode_id irbtree_min(const irbtree *t) {
+  return irbtree_subtree_min(t, t->root);
+}
+
+inode_id irbtree_max(const irbtree *t) {
+  return irbtree_subtree_max(t, t->root);
+}
+
+inode_id irbtree_next(const irbtree *t, const inode_id i) {
+  return irbtree_successor(t, i);
+}
+
+int irbtree_erase(irbtree *t, const inode_id z) {
+  irbtree_unlink(t, z);
+  IN(t, z).left = t->free_list;
+  t->free_list = z;
+  t->size--;
+  return 0;
+}
+
+int irbtree_to_array(const irbtree *t, key_t *arr, const size_t n) {
+  return irbtree_export(t, arr, n);
+}
@@ -0,0 +1,86 @@
+#ifndef _RBTREE_PACKED_H_
+#define _RBTREE_PACKED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rbtree.h"
+
+// sentinel 없는 compact 모드. NULL(또는 0번 index)을 nil 대신 쓰고, color는 parent 링크의 하위 1bit에 저장한다.
+// node 크기가 실제로 줄어드는 것은 irbtree(16byte)뿐이다. prbtree는 color bit를 떼어내도 4byte key 뒤의
+// padding 때문에 {color, key, parent, left, right}를 그대로 둔 node와 같은 32byte이므로,
+// 크기 이득 없이 sentinel과 size 필드가 없는 포인터 기반 비교 기준으로만 쓴다.
+
+// 포인터 링크: color를 parent 포인터의 최하위 bit에 저장 (node는 8byte 정렬, 64bit에서 32byte)
+typedef struct pnode_t {
+  uintptr_t parent_color;
+  struct pnode_t *left, *right;
+  key_t key;
+} pnode_t;
+
+typedef struct prbtree_chunk prbtree_chunk;
+
+typedef struct {
+  pnode_t *root;
+  size_t size;
+
+  prbtree_chunk *chunks;
+  size_t chunk_used;
+  pnode_t *free_list;
+} prbtree;
+
+prbtree *new_prbtree(void);
+void delete_prbtree(prbtree *);
+
+pnode_t *prbtree_insert(prbtree *, const key_t);
+pnode_t *prbtree_find(const prbtree *, const key_t);
+pnode_t *prbtree_min(const prbtree *);
+pnode_t *prbtree_max(const prbtree *);
+pnode_t *prbtree_next(const prbtree *, const pnode_t *);
+int prbtree_erase(prbtree *, pnode_t *);
+int prbtree_to_array(const prbtree *, key_t *, const size_t);
+
+#define PRBTREE_PARENT(n) ((pnode_t *)((n)->parent_color & ~(uintptr_t)1))
+#define PRBTREE_COLOR(n) ((color_t)((n)->parent_color & 1))
+
+// 32bit index 링크: node는 하나의 배열에 있고 0번 index가 NULL 역할을 한다.
+// parent index를 1bit 왼쪽으로 밀고 하위 bit에 color를 넣으므로 최대 2^31 - 1개의 node.
+typedef uint32_t inode_id;
+
+typedef struct {
+  uint32_t parent_color;
+  inode_id left, right;
+  key_t key;
+} inode_t;
+
+typedef struct {
+  inode_t *nodes;  // nodes[0]은 사용하지 않음
+  inode_id root;
+  size_t size;
+
+  uint32_t cap, used;
+  inode_id free_list;
+} irbtree;
+
+_Static_assert(sizeof(inode_t) == 16, "inode_t is the layout that actually shrinks the node");
+
+#define IRBTREE_NIL ((inode_id)0)
+#define IRBTREE_MAX_NODES ((uint32_t)0x7fffffff)
+
+irbtree *new_irbtree(void);
+void delete_irbtree(irbtree *);
+
+// 반환된 index는 다른 insert 후에도 유효하지만 nodes 포인터는 재할당될 수 있다.
+inode_id irbtree_insert(irbtree *, const key_t);
+inode_id irbtree_find(const irbtree *, const key_t);
+inode_id irbtree_min(const irbtree *);
+inode_id irbtree_max(const irbtree *);
+inode_id irbtree_next(const irbtree *, const inode_id);
+int irbtree_erase(irbtree *, const inode_id);
+int irbtree_to_array(const irbtree *, key_t *, const size_t);
+
+#define IRBTREE_PARENT(t, i) ((inode_id)((t)->nodes[i].parent_color >> 1))
+#define IRBTREE_COLOR(t, i) ((color_t)((t)->nodes[i].parent_color & 1))
+#define IRBTREE_KEY(t, i) ((t)->nodes[i].key)
+
+#endif  // _RBTREE_PACKED_H_
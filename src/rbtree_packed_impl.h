@@ -0,0 +1,317 @@
+// sentinel 없는 RB tree 알고리즘 template. rbtree_packed.c 안에서만 include 한다.
+// include 하기 전에 다음 매크로를 정의해야 한다.
+//
+//   PK(fn)                함수 이름 prefix
+//   PK_TREE, PK_LINK      트리 타입, 링크 타입 (포인터 또는 index)
+//   PK_NULL               빈 링크
+//   PK_ROOT(t)            루트 링크 (lvalue)
+//   PK_LEFT(t, x)         왼쪽/오른쪽 자식 링크 (lvalue)
+//   PK_RIGHT(t, x)
+//   PK_KEY(t, x)
+//   PK_PARENT(t, x)       parent 링크
+//   PK_SET_PARENT(t, x, p)  color는 유지한 채 parent 변경
+//   PK_COLOR(t, x)
+//   PK_SET_COLOR(t, x, c)   parent는 유지한 채 color 변경
+
+#define PK_IS_RED(t, x) ((x) != PK_NULL && PK_COLOR(t, x) == RBTREE_RED)
+
+static void PK(left_rotate)(PK_TREE *t, PK_LINK x)
+{
+  PK_LINK y = PK_RIGHT(t, x);
+  PK_LINK p = PK_PARENT(t, x);
+
+  PK_RIGHT(t, x) = PK_LEFT(t, y);
+  if (PK_LEFT(t, y) != PK_NULL) PK_SET_PARENT(t, PK_LEFT(t, y), x);
+  PK_SET_PARENT(t, y, p);
+  if (p == PK_NULL)               PK_ROOT(t) = y;
+  else if (x == PK_LEFT(t, p))    PK_LEFT(t, p) = y;
+  else                            PK_RIGHT(t, p) = y;
+  PK_LEFT(t, y) = x;
+  PK_SET_PARENT(t, x, y);
+}
+
+static void PK(right_rotate)(PK_TREE *t, PK_LINK x)
+{
+  PK_LINK y = PK_LEFT(t, x);
+  PK_LINK p = PK_PARENT(t, x);
+
+  PK_LEFT(t, x) = PK_RIGHT(t, y);
+  if (PK_RIGHT(t, y) != PK_NULL) PK_SET_PARENT(t, PK_RIGHT(t, y), x);
+  PK_SET_PARENT(t, y, p);
+  if (p == PK_NULL)               PK_ROOT(t) = y;
+  else if (x == PK_RIGHT(t, p))   PK_RIGHT(t, p) = y;
+  else                            PK_LEFT(t, p) = y;
+  PK_RIGHT(t, y) = x;
+  PK_SET_PARENT(t, x, y);
+}
+
+static void PK(insert_fixup)(PK_TREE *t, PK_LINK z)
+{
+  PK_LINK p;
+
+  while ((p = PK_PARENT(t, z)) != PK_NULL && PK_COLOR(t, p) == RBTREE_RED)
+  {
+    PK_LINK g = PK_PARENT(t, p);                         // p가 red이므로 루트가 아니다
+    if (p == PK_LEFT(t, g))
+    {
+      PK_LINK uncle = PK_RIGHT(t, g);
+      if (PK_IS_RED(t, uncle))
+      {
+        PK_SET_COLOR(t, p, RBTREE_BLACK);
+        PK_SET_COLOR(t, uncle, RBTREE_BLACK);
+        PK_SET_COLOR(t, g, RBTREE_RED);
+        z = g;
+      }
+      else
+      {
+        if (z == PK_RIGHT(t, p))
+        {
+          z = p;
+          PK(left_rotate)(t, z);
+          p = PK_PARENT(t, z);
+        }
+        PK_SET_COLOR(t, p, RBTREE_BLACK);
+        PK_SET_COLOR(t, g, RBTREE_RED);
+        PK(right_rotate)(t, g);
+      }
+    }
+    else
+    {
+      PK_LINK uncle = PK_LEFT(t, g);
+      if (PK_IS_RED(t, uncle))
+      {
+        PK_SET_COLOR(t, p, RBTREE_BLACK);
+        PK_SET_COLOR(t, uncle, RBTREE_BLACK);
+        PK_SET_COLOR(t, g, RBTREE_RED);
+        z = g;
+      }
+      else
+      {
+        if (z == PK_LEFT(t, p))
+        {
+          z = p;
+          PK(right_rotate)(t, z);
+          p = PK_PARENT(t, z);
+        }
+        PK_SET_COLOR(t, p, RBTREE_BLACK);
+        PK_SET_COLOR(t, g, RBTREE_RED);
+        PK(left_rotate)(t, g);
+      }
+    }
+  }
+  PK_SET_COLOR(t, PK_ROOT(t), RBTREE_BLACK);
+}
+
+// key가 이미 채워진 z를 트리에 연결한다.
+static void PK(link)(PK_TREE *t, PK_LINK z)
+{
+  const key_t key = PK_KEY(t, z);
+  PK_LINK parent = PK_NULL;
+  PK_LINK ptr = PK_ROOT(t);
+  int go_left = 0;
+
+  while (ptr != PK_NULL)
+  {
+    parent = ptr;
+    go_left = key < PK_KEY(t, ptr);
+    ptr = go_left ? PK_LEFT(t, ptr) : PK_RIGHT(t, ptr);
+  }
+
+  PK_LEFT(t, z) = PK_NULL;
+  PK_RIGHT(t, z) = PK_NULL;
+  PK_SET_PARENT(t, z, parent);
+  PK_SET_COLOR(t, z, RBTREE_RED);
+  if (parent == PK_NULL)  PK_ROOT(t) = z;
+  else if (go_left)       PK_LEFT(t, parent) = z;
+  else                    PK_RIGHT(t, parent) = z;
+
+  PK(insert_fixup)(t, z);
+}
+
+static PK_LINK PK(lookup)(const PK_TREE *t, const key_t key)
+{
+  PK_LINK ptr = PK_ROOT(t);
+
+  while (ptr != PK_NULL)
+  {
+    if (PK_KEY(t, ptr) > key)       ptr = PK_LEFT(t, ptr);
+    else if (PK_KEY(t, ptr) < key)  ptr = PK_RIGHT(t, ptr);
+    else                            return ptr;
+  }
+
+  return PK_NULL;
+}
+
+static PK_LINK PK(subtree_min)(const PK_TREE *t, PK_LINK ptr)
+{
+  if (ptr == PK_NULL) return ptr;
+  while (PK_LEFT(t, ptr) != PK_NULL) ptr = PK_LEFT(t, ptr);
+  return ptr;
+}
+
+static PK_LINK PK(subtree_max)(const PK_TREE *t, PK_LINK ptr)
+{
+  if (ptr == PK_NULL) return ptr;
+  while (PK_RIGHT(t, ptr) != PK_NULL) ptr = PK_RIGHT(t, ptr);
+  return ptr;
+}
+
+static PK_LINK PK(successor)(const PK_TREE *t, PK_LINK x)
+{
+  if (PK_RIGHT(t, x) != PK_NULL) return PK(subtree_min)(t, PK_RIGHT(t, x));
+
+  PK_LINK y = PK_PARENT(t, x);
+  while (y != PK_NULL && x == PK_RIGHT(t, y))
+  {
+    x = y;
+    y = PK_PARENT(t, y);
+  }
+  return y;
+}
+
+static void PK(transplant)(PK_TREE *t, PK_LINK u, PK_LINK v)
+{
+  PK_LINK p = PK_PARENT(t, u);
+
+  if (p == PK_NULL)              PK_ROOT(t) = v;
+  else if (u == PK_LEFT(t, p))   PK_LEFT(t, p) = v;
+  else                           PK_RIGHT(t, p) = v;
+  if (v != PK_NULL) PK_SET_PARENT(t, v, p);
+}
+
+// sentinel이 없으므로 x가 NULL일 수 있어 x의 부모 xp를 따로 들고 다닌다.
+static void PK(delete_fixup)(PK_TREE *t, PK_LINK x, PK_LINK xp)
+{
+  PK_LINK w;
+
+  while (x != PK_ROOT(t) && !PK_IS_RED(t, x))
+  {
+    if (x == PK_LEFT(t, xp))
+    {
+      w = PK_RIGHT(t, xp);
+      if (PK_IS_RED(t, w))
+      {
+        PK_SET_COLOR(t, w, RBTREE_BLACK);
+        PK_SET_COLOR(t, xp, RBTREE_RED);
+        PK(left_rotate)(t, xp);
+        w = PK_RIGHT(t, xp);
+      }
+      if (!PK_IS_RED(t, PK_LEFT(t, w)) && !PK_IS_RED(t, PK_RIGHT(t, w)))
+      {
+        PK_SET_COLOR(t, w, RBTREE_RED);
+        x = xp;
+        xp = PK_PARENT(t, x);
+      }
+      else
+      {
+        if (!PK_IS_RED(t, PK_RIGHT(t, w)))
+        {
+          PK_SET_COLOR(t, PK_LEFT(t, w), RBTREE_BLACK);
+          PK_SET_COLOR(t, w, RBTREE_RED);
+          PK(right_rotate)(t, w);
+          w = PK_RIGHT(t, xp);
+        }
+        PK_SET_COLOR(t, w, PK_COLOR(t, xp));
+        PK_SET_COLOR(t, xp, RBTREE_BLACK);
+        PK_SET_COLOR(t, PK_RIGHT(t, w), RBTREE_BLACK);
+        PK(left_rotate)(t, xp);
+        x = PK_ROOT(t);
+        xp = PK_NULL;
+      }
+    }
+    else
+    {
+      w = PK_LEFT(t, xp);
+      if (PK_IS_RED(t, w))
+      {
+        PK_SET_COLOR(t, w, RBTREE_BLACK);
+        PK_SET_COLOR(t, xp, RBTREE_RED);
+        PK(right_rotate)(t, xp);
+        w = PK_LEFT(t, xp);
+      }
+      if (!PK_IS_RED(t, PK_RIGHT(t, w)) && !PK_IS_RED(t, PK_LEFT(t, w)))
+      {
+        PK_SET_COLOR(t, w, RBTREE_RED);
+        x = xp;
+        xp = PK_PARENT(t, x);
+      }
+      else
+      {
+        if (!PK_IS_RED(t, PK_LEFT(t, w)))
+        {
+          PK_SET_COLOR(t, PK_RIGHT(t, w), RBTREE_BLACK);
+          PK_SET_COLOR(t, w, RBTREE_RED);
+          PK(left_rotate)(t, w);
+          w = PK_LEFT(t, xp);
+        }
+        PK_SET_COLOR(t, w, PK_COLOR(t, xp));
+        PK_SET_COLOR(t, xp, RBTREE_BLACK);
+        PK_SET_COLOR(t, PK_LEFT(t, w), RBTREE_BLACK);
+        PK(right_rotate)(t, xp);
+        x = PK_ROOT(t);
+        xp = PK_NULL;
+      }
+    }
+  }
+  if (x != PK_NULL) PK_SET_COLOR(t, x, RBTREE_BLACK);
+}
+
+// z를 트리에서 떼어낸다. z의 메모리 반환은 호출한 쪽에서 한다.
+static void PK(unlink)(PK_TREE *t, PK_LINK z)
+{
+  PK_LINK y = z;
+  PK_LINK x;
+  PK_LINK xp;
+  color_t y_original_color = PK_COLOR(t, y);
+
+  if (PK_LEFT(t, z) == PK_NULL)
+  {
+    x = PK_RIGHT(t, z);
+    xp = PK_PARENT(t, z);
+    PK(transplant)(t, z, x);
+  }
+  else if (PK_RIGHT(t, z) == PK_NULL)
+  {
+    x = PK_LEFT(t, z);
+    xp = PK_PARENT(t, z);
+    PK(transplant)(t, z, x);
+  }
+  else
+  {
+    y = PK(subtree_min)(t, PK_RIGHT(t, z));
+    y_original_color = PK_COLOR(t, y);
+    x = PK_RIGHT(t, y);
+    if (PK_PARENT(t, y) == z)
+    {
+      xp = y;
+    }
+    else
+    {
+      xp = PK_PARENT(t, y);
+      PK(transplant)(t, y, x);
+      PK_RIGHT(t, y) = PK_RIGHT(t, z);
+      PK_SET_PARENT(t, PK_RIGHT(t, y), y);
+    }
+    PK(transplant)(t, z, y);
+    PK_LEFT(t, y) = PK_LEFT(t, z);
+    PK_SET_PARENT(t, PK_LEFT(t, y), y);
+    PK_SET_COLOR(t, y, PK_COLOR(t, z));
+  }
+
+  if (y_original_color == RBTREE_BLACK) PK(delete_fixup)(t, x, xp);
+}
+
+static int PK(export)(const PK_TREE *t, key_t *arr, const size_t n)
+{
+  PK_LINK ptr = PK(subtree_min)(t, PK_ROOT(t));
+  size_t i = 0;
+
+  while (i < n && ptr != PK_NULL)
+  {
+    arr[i++] = PK_KEY(t, ptr);
+    ptr = PK(successor)(t, ptr);
+  }
+  return (int)i;
+}
+
+#undef PK_IS_RED
@@ -0,0 +1,578 @@
+#include "rbtree_parallel.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// 이보다 작은 서브트리는 task로 나누지 않고 한 thread에서 처리한다
+#define RBTREE_PARALLEL_GRAIN 4096
+// 작업자마다 쌓아 둘 수 있는 task 수. 가득 차면 fork하지 않고 바로 실행한다.
+#define RBTREE_POOL_DEQUE 256
+
+// ---------------------------------------------------------------------------
+// work-stealing pool
+//
+// 작업자마다 deque가 하나씩 있다. 자기 deque의 bottom에 task를 넣고 빼며,
+// 할 일이 없는 작업자는 다른 작업자 deque의 top(가장 오래된, 보통 가장 큰 task)을 훔친다.
+// bulk 연산을 호출한 thread는 0번 작업자가 된다.
+
+typedef struct rbtree_task rbtree_task;
+
+struct rbtree_task {
+  void (*run)(rbtree_task *);
+  atomic_int done;
+};
+
+typedef struct {
+  pthread_mutex_t lock;
+  rbtree_pool *pool;
+  size_t top, bottom;                                    // [top, bottom)에 task가 있다
+  rbtree_task *tasks[RBTREE_POOL_DEQUE];
+} __attribute__((aligned(64))) rbtree_deque;
+
+struct rbtree_pool {
+  size_t n;
+  rbtree_deque *deques;
+  pthread_t *threads;
+
+  pthread_mutex_t op_lock;                               // 한 번에 하나의 bulk 연산만
+  pthread_mutex_t idle_lock;
+  pthread_cond_t wake;
+  atomic_int active, shutdown;
+};
+
+static _Thread_local size_t rbtree_worker_id;
+static _Thread_local uint64_t rbtree_worker_rng;
+
+static int rbtree_deque_push(rbtree_deque *d, rbtree_task *task)
+{
+  pthread_mutex_lock(&d->lock);
+  const int ok = d->bottom < RBTREE_POOL_DEQUE;
+  if (ok) d->tasks[d->bottom++] = task;
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+// bottom의 task가 아직 task 그대로(도둑맞지 않음)일 때만 꺼낸다
+static int rbtree_deque_pop(rbtree_deque *d, const rbtree_task *task)
+{
+  pthread_mutex_lock(&d->lock);
+  const int ok = d->bottom > d->top && d->tasks[d->bottom - 1] == task;
+  if (ok && --d->bottom == d->top) d->top = d->bottom = 0;
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+static rbtree_task *rbtree_deque_steal(rbtree_deque *d)
+{
+  rbtree_task *task = NULL;
+
+  pthread_mutex_lock(&d->lock);
+  if (d->top < d->bottom)
+  {
+    task = d->tasks[d->top++];
+    if (d->top == d->bottom) d->top = d->bottom = 0;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return task;
+}
+
+static rbtree_task *rbtree_pool_steal(rbtree_pool *pool)
+{
+  uint64_t x = rbtree_worker_rng;                        // xorshift로 고른 곳부터 한 바퀴
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  rbtree_worker_rng = x;
+
+  for (size_t i = 0; i < pool->n; i++)
+  {
+    const size_t victim = (x + i) % pool->n;
+    if (victim == rbtree_worker_id) continue;
+
+    rbtree_task *task = rbtree_deque_steal(&pool->deques[victim]);
+    if (task != NULL) return task;
+  }
+  return NULL;
+}
+
+static void rbtree_task_run(rbtree_task *task)
+{
+  task->run(task);
+  atomic_store_explicit(&task->done, 1, memory_order_release);
+}
+
+// a와 b를 실행한다. parallel이면 a를 다른 작업자가 훔쳐 갈 수 있게 내놓고 b를 직접 실행한다.
+static void rbtree_pool_invoke2(rbtree_pool *pool, rbtree_task *a, rbtree_task *b, const int parallel)
+{
+  rbtree_deque *self = (pool != NULL) ? &pool->deques[rbtree_worker_id] : NULL;
+
+  atomic_store_explicit(&a->done, 0, memory_order_relaxed);
+  if (self == NULL || !parallel || pool->n == 1 || !rbtree_deque_push(self, a))
+  {
+    a->run(a);
+    b->run(b);
+    return;
+  }
+
+  b->run(b);
+  if (rbtree_deque_pop(self, a))
+  {
+    a->run(a);
+    return;
+  }
+
+  // a를 도둑맞았으면 끝날 때까지 다른 task를 도우며 기다린다
+  while (!atomic_load_explicit(&a->done, memory_order_acquire))
+  {
+    rbtree_task *task = rbtree_pool_steal(pool);
+    if (task != NULL) rbtree_task_run(task);
+    else              sched_yield();
+  }
+}
+
+static void *rbtree_worker_main(void *arg)
+{
+  rbtree_deque *d = (rbtree_deque *)arg;
+  rbtree_pool *pool = d->pool;
+
+  rbtree_worker_id = (size_t)(d - pool->deques);
+  rbtree_worker_rng = 0x9e3779b97f4a7c15ull * (rbtree_worker_id + 1);
+
+  while (!atomic_load(&pool->shutdown))
+  {
+    if (!atomic_load(&pool->active))                     // 진행 중인 연산이 없으면 잠든다
+    {
+      pthread_mutex_lock(&pool->idle_lock);
+      while (!atomic_load(&pool->active) && !atomic_load(&pool->shutdown))
+        pthread_cond_wait(&pool->wake, &pool->idle_lock);
+      pthread_mutex_unlock(&pool->idle_lock);
+      continue;
+    }
+
+    rbtree_task *task = rbtree_pool_steal(pool);
+    if (task != NULL) rbtree_task_run(task);
+    else              sched_yield();
+  }
+  return NULL;
+}
+
+// task 하나를 루트로 하는 bulk 연산을 실행하고 끝날 때까지 기다린다
+static void rbtree_pool_execute(rbtree_pool *pool, rbtree_task *task)
+{
+  if (pool == NULL)
+  {
+    task->run(task);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->op_lock);
+  const size_t saved_id = rbtree_worker_id;
+  rbtree_worker_id = 0;
+  rbtree_worker_rng = 0x9e3779b97f4a7c15ull;
+
+  pthread_mutex_lock(&pool->idle_lock);
+  atomic_store(&pool->active, 1);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->idle_lock);
+
+  task->run(task);                                       // fork한 task는 모두 join된 뒤에 돌아온다
+
+  atomic_store(&pool->active, 0);
+  rbtree_worker_id = saved_id;
+  pthread_mutex_unlock(&pool->op_lock);
+}
+
+rbtree_pool *new_rbtree_pool(const size_t threads) {
+  rbtree_pool *pool = (rbtree_pool *)calloc(1, sizeof(rbtree_pool));
+  long n = (threads > 0) ? (long)threads : sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (n < 1) n = 1;
+  if (pool != NULL)
+  {
+    pool->deques = (rbtree_deque *)aligned_alloc(64, n * sizeof(rbtree_deque));
+    pool->threads = (pthread_t *)calloc(n, sizeof(pthread_t));
+  }
+  if (pool == NULL || pool->deques == NULL || pool->threads == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  pool->n = (size_t)n;
+  pthread_mutex_init(&pool->op_lock, NULL);
+  pthread_mutex_init(&pool->idle_lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  for (size_t i = 0; i < pool->n; i++)
+  {
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+    pool->deques[i].pool = pool;
+    pool->deques[i].top = pool->deques[i].bottom = 0;
+  }
+  for (size_t i = 1; i < pool->n; i++)                   // 0번은 호출한 thread
+  {
+    if (pthread_create(&pool->threads[i], NULL, rbtree_worker_main, &pool->deques[i]) != 0)
+    {
+      fprintf(stderr, "Thread creation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return pool;
+}
+
+void delete_rbtree_pool(rbtree_pool *pool) {
+  if (pool == NULL) return;
+
+  pthread_mutex_lock(&pool->idle_lock);
+  atomic_store(&pool->shutdown, 1);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->idle_lock);
+  for (size_t i = 1; i < pool->n; i++) pthread_join(pool->threads[i], NULL);
+
+  for (size_t i = 0; i < pool->n; i++) pthread_mutex_destroy(&pool->deques[i].lock);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->idle_lock);
+  pthread_mutex_destroy(&pool->op_lock);
+  free(pool->threads);
+  free(pool->deques);
+  free(pool);
+}
+
+// ---------------------------------------------------------------------------
+// union: b의 루트 key로 a를 나누고 양쪽을 재귀적으로 합친 뒤 b의 루트로 join한다.
+
+typedef struct {
+  rbtree_task task;
+  rbtree_pool *pool;
+  const rbtree *t;
+  node_t *a, *b;
+  node_t *root;
+} rbtree_union_task;
+
+static void rbtree_union_run(rbtree_task *p)
+{
+  rbtree_union_task *u = (rbtree_union_task *)p;
+  node_t *nil = u->t->nil;
+  node_t *b = u->b;
+
+  if (u->a == nil || b == nil)
+  {
+    u->root = (u->a == nil) ? b : u->a;
+    return;
+  }
+
+  const int parallel = u->a->size + b->size > RBTREE_PARALLEL_GRAIN;
+  rbtree_union_task left = {{rbtree_union_run}, u->pool, u->t, NULL, b->left, NULL};
+  rbtree_union_task right = {{rbtree_union_run}, u->pool, u->t, NULL, b->right, NULL};
+
+  rbtree_split_subtree(u->t, u->a, b->key, 0, &left.a, &right.a);
+  rbtree_pool_invoke2(u->pool, &left.task, &right.task, parallel);
+  u->root = rbtree_join_subtrees(u->t, left.root, b, right.root);
+}
+
+// 다른 트리의 서브트리 from을 dst의 node 배열에 in-order 순서대로 복사한다
+typedef struct {
+  rbtree_task task;
+  rbtree_pool *pool;
+  const rbtree *src;
+  const node_t *from;
+  const rbtree *dst;
+  node_t *nodes;
+  node_t *parent;
+  node_t *root;
+} rbtree_copy_task;
+
+static void rbtree_copy_run(rbtree_task *p)
+{
+  rbtree_copy_task *c = (rbtree_copy_task *)p;
+  const node_t *from = c->from;
+
+  if (from == c->src->nil)
+  {
+    c->root = c->dst->nil;
+    return;
+  }
+
+  const size_t left_size = from->left->size;
+  node_t *n = &c->nodes[left_size];
+  rbtree_copy_task left = {{rbtree_copy_run}, c->pool, c->src, from->left, c->dst, c->nodes, n, NULL};
+  rbtree_copy_task right = {{rbtree_copy_run}, c->pool, c->src, from->right, c->dst,
+                            c->nodes + left_size + 1, n, NULL};
+
+  n->key = from->key;
+  n->color = from->color;
+  n->size = from->size;
+  n->parent = c->parent;
+  rbtree_pool_invoke2(c->pool, &left.task, &right.task, from->size > RBTREE_PARALLEL_GRAIN);
+  n->left = left.root;
+  n->right = right.root;
+  c->root = n;
+}
+
+void rbtree_union(rbtree_pool *pool, rbtree *t, const rbtree *other) {
+  const size_t m = rbtree_size(other);
+
+  if (m == 0) return;
+
+  // counted 트리는 같은 key를 node 하나로 모아야 하므로 node를 옮겨 붙이지 않고 하나씩 넣는다
+  if (t->counted || other->counted)
+  {
+    key_t *keys = (key_t *)malloc(m * sizeof(key_t));
+    if (keys == NULL)
+    {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    rbtree_to_array(other, keys, m);
+    rbtree_insert_batch(t, keys, m);
+    free(keys);
+    return;
+  }
+
+  rbtree_copy_task copy = {{rbtree_copy_run}, pool, other, other->root, t,
+                           rbtree_reserve_nodes(t, m), t->nil, NULL};
+  rbtree_pool_execute(pool, &copy.task);
+
+  rbtree_union_task u = {{rbtree_union_run}, pool, t, t->root, copy.root, NULL};
+  rbtree_pool_execute(pool, &u.task);
+  t->root = rbtree_join2_subtrees(t, u.root, t->nil);    // 결과를 루트로 떼어낸다
+}
+
+// ---------------------------------------------------------------------------
+// intersection/difference: other의 루트 key로 a를 <, ==, > 세 부분으로 나누고
+// 양쪽을 재귀적으로 거른 뒤 ==부분을 남기거나 버리고 다시 join한다.
+// 버린 node는 parent로 연결한 목록으로 모아 마지막에 한 번에 free list로 돌려준다.
+
+static void rbtree_drop_subtree(const rbtree *t, node_t *r, node_t **head, node_t **tail)
+{
+  // 재귀 없이 후위 순회: 잎을 떼어 목록에 넣고 parent로 올라간다
+  node_t *p = r;
+
+  while (p != t->nil)
+  {
+    if (p->left != t->nil)        p = p->left;
+    else if (p->right != t->nil)  p = p->right;
+    else
+    {
+      node_t *up = (p == r) ? t->nil : p->parent;
+      if (up != t->nil)
+      {
+        if (up->left == p)  up->left = t->nil;
+        else                up->right = t->nil;
+      }
+      p->parent = *head;
+      *head = p;
+      if (*tail == NULL) *tail = p;
+      p = up;
+    }
+  }
+}
+
+static void rbtree_list_append(node_t **head, node_t **tail, node_t *h, node_t *tl)
+{
+  if (h == NULL) return;
+
+  if (*head == NULL) *head = h;
+  else               (*tail)->parent = h;
+  *tail = tl;
+}
+
+typedef struct {
+  rbtree_task task;
+  rbtree_pool *pool;
+  const rbtree *t, *other;
+  node_t *a;
+  const node_t *b;
+  int keep;                                              // 1이면 intersection, 0이면 difference
+  node_t *root, *dropped, *dropped_tail;
+} rbtree_filter_task;
+
+static void rbtree_filter_run(rbtree_task *p)
+{
+  rbtree_filter_task *f = (rbtree_filter_task *)p;
+  const rbtree *t = f->t;
+  const node_t *b = f->b;
+
+  f->dropped = f->dropped_tail = NULL;
+  if (f->a == t->nil || b == f->other->nil)
+  {
+    f->root = f->a;
+    if (f->keep)                                         // 맞춰 볼 key가 없으니 모두 버린다
+    {
+      rbtree_drop_subtree(t, f->a, &f->dropped, &f->dropped_tail);
+      f->root = t->nil;
+    }
+    return;
+  }
+
+  const int parallel = f->a->size > RBTREE_PARALLEL_GRAIN;
+  rbtree_filter_task left = {{rbtree_filter_run}, f->pool, t, f->other, NULL, b->left, f->keep};
+  rbtree_filter_task right = {{rbtree_filter_run}, f->pool, t, f->other, NULL, b->right, f->keep};
+  node_t *rest, *equal;
+
+  rbtree_split_subtree(t, f->a, b->key, 0, &left.a, &rest);
+  rbtree_split_subtree(t, rest, b->key, 1, &equal, &right.a);
+  rbtree_pool_invoke2(f->pool, &left.task, &right.task, parallel);
+
+  if (f->keep)
+  {
+    f->root = rbtree_join2_subtrees(t, rbtree_join2_subtrees(t, left.root, equal), right.root);
+  }
+  else
+  {
+    rbtree_drop_subtree(t, equal, &f->dropped, &f->dropped_tail);
+    f->root = rbtree_join2_subtrees(t, left.root, right.root);
+  }
+  rbtree_list_append(&f->dropped, &f->dropped_tail, left.dropped, left.dropped_tail);
+  rbtree_list_append(&f->dropped, &f->dropped_tail, right.dropped, right.dropped_tail);
+}
+
+static void rbtree_filter(rbtree_pool *pool, rbtree *t, const rbtree *other, const int keep)
+{
+  if (t == other)                                        // 자기 자신과는 나눌 수 없다
+  {
+    if (keep) return;
+
+    node_t *head = NULL, *tail = NULL;
+    rbtree_drop_subtree(t, t->root, &head, &tail);
+    rbtree_release_nodes(t, head, tail);
+    t->root = t->nil;
+    return;
+  }
+
+  rbtree_filter_task f = {{rbtree_filter_run}, pool, t, other, t->root, other->root, keep};
+  rbtree_pool_execute(pool, &f.task);
+  t->root = rbtree_join2_subtrees(t, f.root, t->nil);
+  rbtree_release_nodes(t, f.dropped, f.dropped_tail);
+}
+
+void rbtree_intersection(rbtree_pool *pool, rbtree *t, const rbtree *other) {
+  rbtree_filter(pool, t, other, 1);
+}
+
+void rbtree_difference(rbtree_pool *pool, rbtree *t, const rbtree *other) {
+  rbtree_filter(pool, t, other, 0);
+}
+
+// ---------------------------------------------------------------------------
+// 정렬된 배열로부터의 build와 to_array는 크기(size)로 각 서브트리의 위치를 바로 알 수 있어
+// 왼쪽과 오른쪽을 서로 독립적으로 처리할 수 있다.
+
+typedef struct {
+  rbtree_task task;
+  rbtree_pool *pool;
+  rbtree *t;
+  node_t *nodes;
+  const key_t *arr;
+  size_t lo, hi;
+  node_t *parent;
+  int depth, red_depth;
+  node_t *root;
+} rbtree_build_task;
+
+static void rbtree_build_run(rbtree_task *p)
+{
+  rbtree_build_task *b = (rbtree_build_task *)p;
+
+  if (b->hi - b->lo <= RBTREE_PARALLEL_GRAIN)
+  {
+    b->root = rbtree_build_sorted(b->t, b->nodes, b->arr, b->lo, b->hi, b->parent, b->depth, b->red_depth);
+    return;
+  }
+
+  // rbtree_build_sorted와 같은 규칙으로 루트를 놓고 양쪽을 나눠 만든다
+  const size_t mid = b->lo + (b->hi - b->lo) / 2;
+  node_t *n = &b->nodes[mid];
+  rbtree_build_task left = *b, right = *b;
+
+  n->key = b->arr[mid];
+  n->parent = b->parent;
+  n->size = b->hi - b->lo;
+  n->color = (b->depth == b->red_depth) ? RBTREE_RED : RBTREE_BLACK;
+  left.hi = mid;
+  right.lo = mid + 1;
+  left.parent = right.parent = n;
+  left.depth = right.depth = b->depth + 1;
+  rbtree_pool_invoke2(b->pool, &left.task, &right.task, 1);
+  n->left = left.root;
+  n->right = right.root;
+  b->root = n;
+}
+
+rbtree *rbtree_from_sorted_array_parallel(rbtree_pool *pool, const key_t *arr, const size_t n) {
+  rbtree *t = new_rbtree();
+
+  if (n == 0) return t;
+
+  int height = 0;
+  while (((size_t)2 << height) <= n) height++;
+
+  rbtree_build_task b = {{rbtree_build_run}, pool, t, rbtree_reserve_nodes(t, n), arr, 0, n,
+                         t->nil, 0, height > 0 ? height : -1, NULL};
+  rbtree_pool_execute(pool, &b.task);
+  t->root = b.root;
+
+  return t;
+}
+
+static void rbtree_export_subtree(const rbtree *t, const node_t *r, key_t *arr, size_t n)
+{
+  // r 서브트리를 arr[0, n)에 in-order로 쓴다 (n을 넘는 부분은 버림)
+  while (r != t->nil && n > 0)
+  {
+    const size_t left_size = r->left->size;
+    rbtree_export_subtree(t, r->left, arr, left_size < n ? left_size : n);
+    if (left_size >= n) return;
+
+    arr[left_size] = r->key;
+    arr += left_size + 1;
+    n -= left_size + 1;
+    r = r->right;
+  }
+}
+
+typedef struct {
+  rbtree_task task;
+  rbtree_pool *pool;
+  const rbtree *t;
+  const node_t *from;
+  key_t *arr;
+  size_t n;
+} rbtree_export_task;
+
+static void rbtree_export_run(rbtree_task *p)
+{
+  rbtree_export_task *e = (rbtree_export_task *)p;
+  const node_t *from = e->from;
+
+  if (from == e->t->nil || e->n == 0) return;
+  if (from->size <= RBTREE_PARALLEL_GRAIN)
+  {
+    rbtree_export_subtree(e->t, from, e->arr, e->n);
+    return;
+  }
+
+  const size_t left_size = from->left->size;
+  const size_t n = e->n;
+  rbtree_export_task left = {{rbtree_export_run}, e->pool, e->t, from->left, e->arr,
+                             left_size < n ? left_size : n};
+  rbtree_export_task right = {{rbtree_export_run}, e->pool, e->t, from->right, e->arr + left_size + 1,
+                              n > left_size + 1 ? n - left_size - 1 : 0};
+
+  if (left_size < n) e->arr[left_size] = from->key;
+  rbtree_pool_invoke2(e->pool, &left.task, &right.task, 1);
+}
+
+size_t rbtree_to_array_parallel(rbtree_pool *pool, const rbtree *t, key_t *arr, const size_t n) {
+  const size_t size = rbtree_size(t);
+
+  if (t->counted) return (size_t)rbtree_to_array(t, arr, n);  // 배열 위치를 서브트리 node 수로 나눌 수 없다
+  rbtree_export_task e = {{rbtree_export_run}, pool, t, t->root, arr, n < size ? n : size};
+
+  rbtree_pool_execute(pool, &e.task);
+  return e.n;
+}
@@ -0,0 +1,28 @@
+#ifndef _RBTREE_PARALLEL_H_
+#define _RBTREE_PARALLEL_H_
+
+#include <stddef.h>
+
+#include "rbtree.h"
+
+// join/split을 이용한 bulk 연산을 work-stealing thread pool 위에서 병렬로 수행한다.
+// pool 자리에 NULL을 넘기면 같은 알고리즘을 호출한 thread 하나에서 순차적으로 실행한다.
+// 하나의 pool은 한 번에 하나의 bulk 연산만 수행하며, 동시에 들어온 호출은 차례를 기다린다.
+typedef struct rbtree_pool rbtree_pool;
+
+// threads는 호출한 thread를 포함한 작업자 수. 0이면 online CPU 수를 쓴다.
+rbtree_pool *new_rbtree_pool(const size_t);
+void delete_rbtree_pool(rbtree_pool *);
+
+// 결과는 첫 번째 트리에 남고 두 번째 트리는 바뀌지 않는다.
+// union은 두 트리의 모든 node를 (중복 key 포함) 합치고,
+// intersection/difference는 두 번째 트리에 key가 있는/없는 node만 남긴다.
+// 어느 한쪽이 counted 트리이면 union은 key를 하나씩 넣고, to_array는 순차로 내보낸다.
+void rbtree_union(rbtree_pool *, rbtree *, const rbtree *);
+void rbtree_intersection(rbtree_pool *, rbtree *, const rbtree *);
+void rbtree_difference(rbtree_pool *, rbtree *, const rbtree *);
+
+rbtree *rbtree_from_sorted_array_parallel(rbtree_pool *, const key_t *, const size_t);
+size_t rbtree_to_array_parallel(rbtree_pool *, const rbtree *, key_t *, const size_t);
+
+#endif  // _RBTREE_PARALLEL_H_
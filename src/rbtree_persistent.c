@@ -0,0 +1,428 @@
+#include "rbtree_persistent.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// 아래 함수들은 모두 인자로 받은 node의 참조를 넘겨받고(consume), 반환하는 node의 참조를 넘겨준다.
+// 공유된 node를 열면(vnode_open) 자식들의 참조가 늘어나고 새 node를 만들게 되므로 자연스럽게 경로 복사가 되고,
+// 아무도 공유하지 않는 node는 그 자리에서 해제한다.
+// 균형은 Kahrs의 함수형 RB 트리 삽입/삭제(balance, balLeft, balRight, app)를 따른다.
+
+static size_t vnode_size(const vnode_t *n)
+{
+  return (n != NULL) ? n->size : 0;
+}
+
+static int vnode_red(const vnode_t *n)
+{
+  return n != NULL && n->color == RBTREE_RED;
+}
+
+static int vnode_black(const vnode_t *n)
+{
+  return n != NULL && n->color == RBTREE_BLACK;
+}
+
+static vnode_t *vnode_retain(vnode_t *n)
+{
+  if (n != NULL) atomic_fetch_add_explicit(&n->refs, 1, memory_order_relaxed);
+  return n;
+}
+
+static void vnode_release(vnode_t *n)
+{
+  while (n != NULL && atomic_fetch_sub_explicit(&n->refs, 1, memory_order_acq_rel) == 1)
+  {
+    vnode_t *r = n->right;
+    vnode_release(n->left);
+    free(n);
+    n = r;                                               // 오른쪽은 반복으로
+  }
+}
+
+static vnode_t *vnode_new(const color_t color, vnode_t *l, const key_t key, vnode_t *r)
+{
+  vnode_t *n = (vnode_t *)malloc(sizeof(vnode_t));
+
+  if (n == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  n->left = l;
+  n->right = r;
+  n->key = key;
+  n->color = color;
+  n->size = vnode_size(l) + vnode_size(r) + 1;
+  atomic_init(&n->refs, 1);
+  return n;
+}
+
+// n의 참조를 두 자식의 참조로 바꾼다. key와 color는 부르기 전에 읽어 두어야 한다.
+static void vnode_open(vnode_t *n, vnode_t **l, vnode_t **r)
+{
+  *l = n->left;
+  *r = n->right;
+  if (atomic_load_explicit(&n->refs, memory_order_acquire) == 1)
+  {
+    free(n);                                             // 우리만 가리키는 node: 자식의 참조를 그대로 넘겨받는다
+    return;
+  }
+  vnode_retain(*l);
+  vnode_retain(*r);
+  vnode_release(n);
+}
+
+static vnode_t *vnode_blacken(vnode_t *n)
+{
+  if (!vnode_red(n)) return n;
+
+  const key_t k = n->key;
+  vnode_t *l, *r;
+  vnode_open(n, &l, &r);
+  return vnode_new(RBTREE_BLACK, l, k, r);
+}
+
+// black node 하나를 red로 바꾼다 (Kahrs의 sub1)
+static vnode_t *vnode_redden(vnode_t *n)
+{
+  const key_t k = n->key;
+  vnode_t *l, *r;
+  vnode_open(n, &l, &r);
+  return vnode_new(RBTREE_RED, l, k, r);
+}
+
+// black node (l, key, r)를 만들면서 자식과 손자 사이의 red-red를 없앤다
+static vnode_t *vnode_balance(vnode_t *l, const key_t key, vnode_t *r)
+{
+  vnode_t *a, *b, *c, *d, *x;
+
+  if (vnode_red(l) && vnode_red(r))
+  {
+    const key_t lk = l->key, rk = r->key;
+    vnode_open(l, &a, &b);
+    vnode_open(r, &c, &d);
+    return vnode_new(RBTREE_RED, vnode_new(RBTREE_BLACK, a, lk, b), key, vnode_new(RBTREE_BLACK, c, rk, d));
+  }
+  if (vnode_red(l) && vnode_red(l->left))
+  {
+    const key_t yk = l->key, xk = l->left->key;
+    vnode_open(l, &x, &c);
+    vnode_open(x, &a, &b);
+    return vnode_new(RBTREE_RED, vnode_new(RBTREE_BLACK, a, xk, b), yk, vnode_new(RBTREE_BLACK, c, key, r));
+  }
+  if (vnode_red(l) && vnode_red(l->right))
+  {
+    const key_t xk = l->key, yk = l->right->key;
+    vnode_open(l, &a, &x);
+    vnode_open(x, &b, &c);
+    return vnode_new(RBTREE_RED, vnode_new(RBTREE_BLACK, a, xk, b), yk, vnode_new(RBTREE_BLACK, c, key, r));
+  }
+  if (vnode_red(r) && vnode_red(r->right))
+  {
+    const key_t yk = r->key, zk = r->right->key;
+    vnode_open(r, &b, &x);
+    vnode_open(x, &c, &d);
+    return vnode_new(RBTREE_RED, vnode_new(RBTREE_BLACK, l, key, b), yk, vnode_new(RBTREE_BLACK, c, zk, d));
+  }
+  if (vnode_red(r) && vnode_red(r->left))
+  {
+    const key_t zk = r->key, yk = r->left->key;
+    vnode_open(r, &x, &d);
+    vnode_open(x, &b, &c);
+    return vnode_new(RBTREE_RED, vnode_new(RBTREE_BLACK, l, key, b), yk, vnode_new(RBTREE_BLACK, c, zk, d));
+  }
+  return vnode_new(RBTREE_BLACK, l, key, r);
+}
+
+static vnode_t *vnode_insert(vnode_t *n, const key_t key)
+{
+  if (n == NULL) return vnode_new(RBTREE_RED, NULL, key, NULL);
+
+  const key_t k = n->key;
+  const color_t color = n->color;
+  vnode_t *l, *r;
+  vnode_open(n, &l, &r);
+
+  if (key < k)  l = vnode_insert(l, key);                // 같은 key는 rbtree_insert처럼 오른쪽으로
+  else          r = vnode_insert(r, key);
+  return (color == RBTREE_BLACK) ? vnode_balance(l, k, r) : vnode_new(RBTREE_RED, l, k, r);
+}
+
+// 왼쪽 서브트리의 black 높이가 하나 줄었을 때
+static vnode_t *vnode_bal_left(vnode_t *l, const key_t key, vnode_t *r)
+{
+  vnode_t *a, *b, *c, *x;
+
+  if (vnode_red(l))
+  {
+    const key_t lk = l->key;
+    vnode_open(l, &a, &b);
+    return vnode_new(RBTREE_RED, vnode_new(RBTREE_BLACK, a, lk, b), key, r);
+  }
+  if (vnode_black(r))
+  {
+    return vnode_balance(l, key, vnode_redden(r));
+  }
+  // r은 red이고 왼쪽 자식은 black
+  const key_t zk = r->key, yk = r->left->key;
+  vnode_open(r, &x, &c);
+  vnode_open(x, &a, &b);
+  return vnode_new(RBTREE_RED, vnode_new(RBTREE_BLACK, l, key, a), yk, vnode_balance(b, zk, vnode_redden(c)));
+}
+
+// 오른쪽 서브트리의 black 높이가 하나 줄었을 때
+static vnode_t *vnode_bal_right(vnode_t *l, const key_t key, vnode_t *r)
+{
+  vnode_t *a, *b, *c, *x;
+
+  if (vnode_red(r))
+  {
+    const key_t rk = r->key;
+    vnode_open(r, &b, &c);
+    return vnode_new(RBTREE_RED, l, key, vnode_new(RBTREE_BLACK, b, rk, c));
+  }
+  if (vnode_black(l))
+  {
+    return vnode_balance(vnode_redden(l), key, r);
+  }
+  // l은 red이고 오른쪽 자식은 black
+  const key_t xk = l->key, yk = l->right->key;
+  vnode_open(l, &a, &x);
+  vnode_open(x, &b, &c);
+  return vnode_new(RBTREE_RED, vnode_balance(vnode_redden(a), xk, b), yk, vnode_new(RBTREE_BLACK, c, key, r));
+}
+
+// 지운 node의 두 서브트리 l, r (l의 모든 key <= r의 모든 key)을 하나로 잇는다
+static vnode_t *vnode_append(vnode_t *l, vnode_t *r)
+{
+  vnode_t *a, *b, *c, *d, *bc, *x, *y;
+
+  if (l == NULL) return r;
+  if (r == NULL) return l;
+
+  const key_t lk = l->key, rk = r->key;
+  if (l->color == r->color)
+  {
+    const color_t color = l->color;
+    vnode_open(l, &a, &b);
+    vnode_open(r, &c, &d);
+    bc = vnode_append(b, c);
+    if (vnode_red(bc))
+    {
+      const key_t mk = bc->key;
+      vnode_open(bc, &x, &y);
+      return vnode_new(RBTREE_RED, vnode_new(color, a, lk, x), mk, vnode_new(color, y, rk, d));
+    }
+    if (color == RBTREE_RED) return vnode_new(RBTREE_RED, a, lk, vnode_new(RBTREE_RED, bc, rk, d));
+    return vnode_bal_left(a, lk, vnode_new(RBTREE_BLACK, bc, rk, d));
+  }
+  if (r->color == RBTREE_RED)
+  {
+    vnode_open(r, &b, &c);
+    return vnode_new(RBTREE_RED, vnode_append(l, b), rk, c);
+  }
+  vnode_open(l, &a, &b);
+  return vnode_new(RBTREE_RED, a, lk, vnode_append(b, r));
+}
+
+// key를 가진 node 하나를 지운다. key가 있는 것은 미리 확인한다.
+static vnode_t *vnode_erase(vnode_t *n, const key_t key)
+{
+  if (n == NULL) return NULL;
+
+  const key_t k = n->key;
+  vnode_t *l, *r;
+  vnode_open(n, &l, &r);
+
+  if (key < k)
+  {
+    const int shrinks = vnode_black(l);                 // black 서브트리에서 지우면 black 높이가 준다
+    l = vnode_erase(l, key);
+    return shrinks ? vnode_bal_left(l, k, r) : vnode_new(RBTREE_RED, l, k, r);
+  }
+  if (k < key)
+  {
+    const int shrinks = vnode_black(r);
+    r = vnode_erase(r, key);
+    return shrinks ? vnode_bal_right(l, k, r) : vnode_new(RBTREE_RED, l, k, r);
+  }
+  return vnode_append(l, r);
+}
+
+static rbtree_version *rbtree_version_wrap(vnode_t *root)
+{
+  rbtree_version *v = (rbtree_version *)malloc(sizeof(rbtree_version));
+
+  if (v == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  v->root = root;
+  atomic_init(&v->refs, 1);
+  return v;
+}
+
+rbtree_version *new_rbtree_version(void) {
+  return rbtree_version_wrap(NULL);
+}
+
+rbtree_version *rbtree_version_retain(rbtree_version *v) {
+  atomic_fetch_add_explicit(&v->refs, 1, memory_order_relaxed);
+  return v;
+}
+
+void rbtree_version_release(rbtree_version *v) {
+  if (v == NULL) return;
+  if (atomic_fetch_sub_explicit(&v->refs, 1, memory_order_acq_rel) != 1) return;
+
+  vnode_release(v->root);
+  free(v);
+}
+
+rbtree_version *rbtree_version_insert(rbtree_version *v, const key_t key) {
+  return rbtree_version_wrap(vnode_blacken(vnode_insert(vnode_retain(v->root), key)));
+}
+
+rbtree_version *rbtree_version_erase(rbtree_version *v, const key_t key) {
+  if (!rbtree_version_contains(v, key)) return rbtree_version_retain(v);
+  return rbtree_version_wrap(vnode_blacken(vnode_erase(vnode_retain(v->root), key)));
+}
+
+size_t rbtree_version_size(const rbtree_version *v) {
+  return vnode_size(v->root);
+}
+
+int rbtree_version_contains(const rbtree_version *v, const key_t key) {
+  const vnode_t *n = v->root;
+
+  while (n != NULL)
+  {
+    if (key < n->key)       n = n->left;
+    else if (n->key < key)  n = n->right;
+    else                    return 1;
+  }
+  return 0;
+}
+
+int rbtree_version_lower_bound(const rbtree_version *v, const key_t key, key_t *out) {
+  const vnode_t *n = v->root, *found = NULL;
+
+  while (n != NULL)
+  {
+    if (n->key < key)
+    {
+      n = n->right;
+    }
+    else
+    {
+      found = n;
+      n = n->left;
+    }
+  }
+  if (found != NULL) *out = found->key;
+  return found != NULL;
+}
+
+// [lo, hi] 안의 key를 in-order로 arr[*j..n)에 기록한다
+static void vnode_range(const vnode_t *x, const key_t lo, const key_t hi, key_t *arr, size_t *j, const size_t n)
+{
+  while (x != NULL && *j < n)
+  {
+    if (x->key < lo)
+    {
+      x = x->right;
+      continue;
+    }
+    vnode_range(x->left, lo, hi, arr, j, n);
+    if (x->key > hi || *j == n) return;
+    arr[(*j)++] = x->key;
+    x = x->right;
+  }
+}
+
+size_t rbtree_version_range(const rbtree_version *v, const key_t lo, const key_t hi, key_t *arr, const size_t n) {
+  size_t j = 0;
+
+  if (lo <= hi) vnode_range(v->root, lo, hi, arr, &j, n);
+  return j;
+}
+
+static void vnode_to_array(const vnode_t *x, key_t *arr, size_t *j, const size_t n)
+{
+  while (x != NULL && *j < n)
+  {
+    vnode_to_array(x->left, arr, j, n);
+    if (*j == n) return;
+    arr[(*j)++] = x->key;
+    x = x->right;
+  }
+}
+
+int rbtree_version_to_array(const rbtree_version *v, key_t *arr, const size_t n) {
+  size_t j = 0;
+
+  vnode_to_array(v->root, arr, &j, n);
+  return (int)j;
+}
+
+rbtree_persistent *new_rbtree_persistent(void) {
+  rbtree_persistent *p = (rbtree_persistent *)calloc(1, sizeof(rbtree_persistent));
+
+  if (p == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  p->current = new_rbtree_version();
+  pthread_mutex_init(&p->write_lock, NULL);
+  pthread_mutex_init(&p->swap_lock, NULL);
+  return p;
+}
+
+void delete_rbtree_persistent(rbtree_persistent *p) {
+  if (p == NULL) return;
+
+  pthread_mutex_destroy(&p->swap_lock);
+  pthread_mutex_destroy(&p->write_lock);
+  rbtree_version_release(p->current);
+  free(p);
+}
+
+// 쓰기 lock을 잡은 채 만든 새 version으로 current를 바꾸고, 이전 version은 lock 밖에서 놓아준다
+static void rbtree_persistent_publish(rbtree_persistent *p, rbtree_version *next)
+{
+  rbtree_version *prev;
+
+  pthread_mutex_lock(&p->swap_lock);
+  prev = p->current;
+  p->current = next;
+  pthread_mutex_unlock(&p->swap_lock);
+  pthread_mutex_unlock(&p->write_lock);
+
+  rbtree_version_release(prev);
+}
+
+void rbtree_persistent_insert(rbtree_persistent *p, const key_t key) {
+  pthread_mutex_lock(&p->write_lock);
+  rbtree_persistent_publish(p, rbtree_version_insert(p->current, key));
+}
+
+int rbtree_persistent_erase(rbtree_persistent *p, const key_t key) {
+  pthread_mutex_lock(&p->write_lock);
+  if (!rbtree_version_contains(p->current, key))
+  {
+    pthread_mutex_unlock(&p->write_lock);
+    return 0;
+  }
+  rbtree_persistent_publish(p, rbtree_version_erase(p->current, key));
+  return 1;
+}
+
+rbtree_version *rbtree_persistent_snapshot(rbtree_persistent *p) {
+  pthread_mutex_lock(&p->swap_lock);
+  rbtree_version *v = rbtree_version_retain(p->current);
+  pthread_mutex_unlock(&p->swap_lock);
+  return v;
+}
@@ -0,0 +1,63 @@
+#ifndef _RBTREE_PERSISTENT_H_
+#define _RBTREE_PERSISTENT_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "rbtree.h"
+
+// 불변(persistent) RB 트리.
+// insert/erase는 기존 version을 바꾸지 않고 루트부터 바뀌는 경로의 node만 복사한 새 version을 만든다.
+// 경로 밖의 서브트리는 이전 version과 공유하며, node마다 자신을 가리키는 부모 node와 version의 수(refs)를 세어
+// 마지막 참조가 사라질 때 해제한다. 공유를 위해 node에는 parent 포인터가 없다.
+// 만들어진 version과 node는 바뀌지 않으므로 version을 가진 reader는 lock 없이 읽는다.
+
+typedef struct vnode_t {
+  struct vnode_t *left, *right;  // 빈 서브트리는 NULL
+  key_t key;
+  color_t color;
+  size_t size;
+  atomic_size_t refs;
+} vnode_t;
+
+typedef struct {
+  vnode_t *root;
+  atomic_size_t refs;
+} rbtree_version;
+
+rbtree_version *new_rbtree_version(void);
+// version을 하나 더 참조한다(O(1) snapshot). 같은 포인터를 반환한다.
+rbtree_version *rbtree_version_retain(rbtree_version *);
+void rbtree_version_release(rbtree_version *);
+
+// 새 version을 반환한다. 인자로 준 version은 그대로 남으며 따로 release 해야 한다.
+rbtree_version *rbtree_version_insert(rbtree_version *, const key_t);
+// key를 가진 node 하나를 지운 새 version. key가 없으면 같은 version을 retain 해서 반환한다.
+rbtree_version *rbtree_version_erase(rbtree_version *, const key_t);
+
+size_t rbtree_version_size(const rbtree_version *);
+int rbtree_version_contains(const rbtree_version *, const key_t);
+int rbtree_version_lower_bound(const rbtree_version *, const key_t, key_t *);
+size_t rbtree_version_range(const rbtree_version *, const key_t, const key_t, key_t *, const size_t);
+// rbtree_to_array처럼 기록한 key 수를 반환한다.
+int rbtree_version_to_array(const rbtree_version *, key_t *, const size_t);
+
+// 쓰기 thread들이 함께 쓰는 현재 version.
+// 쓰기는 write_lock으로 직렬화하고, current를 바꾸거나 retain 하는 짧은 구간만 swap_lock으로 보호한다.
+// 따라서 snapshot은 경로 복사가 진행 중이어도 기다리지 않는다.
+typedef struct {
+  rbtree_version *current;
+  pthread_mutex_t write_lock;
+  pthread_mutex_t swap_lock;
+} rbtree_persistent;
+
+rbtree_persistent *new_rbtree_persistent(void);
+void delete_rbtree_persistent(rbtree_persistent *);
+
+void rbtree_persistent_insert(rbtree_persistent *, const key_t);
+int rbtree_persistent_erase(rbtree_persistent *, const key_t);
+// 현재 version을 retain 해서 반환한다. 다 읽은 뒤 rbtree_version_release로 놓아준다.
+rbtree_version *rbtree_persistent_snapshot(rbtree_persistent *);
+
+#endif  // _RBTREE_PERSISTENT_H_
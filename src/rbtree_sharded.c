@@ -0,0 +1,215 @@
+#include "rbtree_sharded.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+rbtree_sharded *new_rbtree_sharded(const size_t n, const rbtree_shard_mode mode) {
+  rbtree_sharded *s = (rbtree_sharded *)calloc(1, sizeof(rbtree_sharded));
+  rbtree_shard *shards = (rbtree_shard *)aligned_alloc(64, (n > 0 ? n : 1) * sizeof(rbtree_shard));
+
+  if (s == NULL || shards == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  s->shards = shards;
+  s->n = (n > 0) ? n : 1;
+  s->mode = mode;
+  for (size_t i = 0; i < s->n; i++)
+  {
+    s->shards[i].tree = new_rbtree();
+    pthread_mutex_init(&s->shards[i].lock, NULL);
+  }
+  return s;
+}
+
+void delete_rbtree_sharded(rbtree_sharded *s) {
+  if (s == NULL) return;
+
+  for (size_t i = 0; i < s->n; i++)
+  {
+    pthread_mutex_destroy(&s->shards[i].lock);
+    delete_rbtree(s->shards[i].tree);
+  }
+  free(s->shards);
+  free(s);
+}
+
+static rbtree_shard *rbtree_shard_of(const rbtree_sharded *s, const key_t key)
+{
+  const uint32_t u = (uint32_t)key;
+
+  // 곱의 아래 bit는 key의 아래 bit로만 정해지므로(곱하는 수가 홀수라 2^k로 나눈 나머지는 key % 2^k의 순열)
+  // stride가 N의 배수인 key가 한 shard로 몰린다. 위 32bit를 N등분해 쓴다.
+  if (s->mode == RBTREE_SHARD_BY_HASH)
+    return &s->shards[((uint64_t)(uint32_t)(u * 2654435761u) * s->n) >> 32];
+
+  // INT_MIN..INT_MAX를 0..2^32-1로 옮긴 뒤 N등분
+  const uint64_t offset = (uint64_t)(u ^ 0x80000000u);
+  return &s->shards[(offset * s->n) >> 32];
+}
+
+void rbtree_sharded_insert(rbtree_sharded *s, const key_t key) {
+  rbtree_shard *sh = rbtree_shard_of(s, key);
+
+  pthread_mutex_lock(&sh->lock);
+  rbtree_insert(sh->tree, key);
+  pthread_mutex_unlock(&sh->lock);
+}
+
+int rbtree_sharded_erase(rbtree_sharded *s, const key_t key) {
+  rbtree_shard *sh = rbtree_shard_of(s, key);
+
+  pthread_mutex_lock(&sh->lock);
+  node_t *p = rbtree_find(sh->tree, key);
+  if (p != NULL) rbtree_erase(sh->tree, p);
+  pthread_mutex_unlock(&sh->lock);
+  return p != NULL;
+}
+
+int rbtree_sharded_contains(rbtree_sharded *s, const key_t key) {
+  rbtree_shard *sh = rbtree_shard_of(s, key);
+
+  pthread_mutex_lock(&sh->lock);
+  int found = rbtree_find(sh->tree, key) != NULL;
+  pthread_mutex_unlock(&sh->lock);
+  return found;
+}
+
+// 항상 index 순서로 잠가서 여러 shard를 잡는 질의끼리 교착되지 않게 한다
+static void rbtree_sharded_lock(rbtree_sharded *s, const size_t first, const size_t last)
+{
+  for (size_t i = first; i <= last; i++) pthread_mutex_lock(&s->shards[i].lock);
+}
+
+static void rbtree_sharded_unlock(rbtree_sharded *s, const size_t first, const size_t last)
+{
+  for (size_t i = last + 1; i > first; i--) pthread_mutex_unlock(&s->shards[i - 1].lock);
+}
+
+#define rbtree_sharded_lock_all(s) rbtree_sharded_lock((s), 0, (s)->n - 1)
+#define rbtree_sharded_unlock_all(s) rbtree_sharded_unlock((s), 0, (s)->n - 1)
+
+int rbtree_sharded_min(rbtree_sharded *s, key_t *out) {
+  int found = 0;
+
+  rbtree_sharded_lock_all(s);
+  for (size_t i = 0; i < s->n; i++)
+  {
+    const rbtree *t = s->shards[i].tree;
+    if (t->root == t->nil) continue;
+    key_t k = rbtree_min(t)->key;
+    if (!found || k < *out) *out = k;
+    found = 1;
+  }
+  rbtree_sharded_unlock_all(s);
+  return found;
+}
+
+int rbtree_sharded_max(rbtree_sharded *s, key_t *out) {
+  int found = 0;
+
+  rbtree_sharded_lock_all(s);
+  for (size_t i = 0; i < s->n; i++)
+  {
+    const rbtree *t = s->shards[i].tree;
+    if (t->root == t->nil) continue;
+    key_t k = rbtree_max(t)->key;
+    if (!found || k > *out) *out = k;
+    found = 1;
+  }
+  rbtree_sharded_unlock_all(s);
+  return found;
+}
+
+size_t rbtree_sharded_size(rbtree_sharded *s) {
+  size_t size = 0;
+
+  rbtree_sharded_lock_all(s);
+  for (size_t i = 0; i < s->n; i++) size += rbtree_size(s->shards[i].tree);
+  rbtree_sharded_unlock_all(s);
+  return size;
+}
+
+// shard별 cursor를 key 기준 min-heap으로 관리하며 [lo, hi]를 key 순서대로 합친다.
+// shards[first..last]가 잠긴 상태에서 호출해야 한다.
+static size_t rbtree_sharded_merge(rbtree_sharded *s, const size_t first, const size_t last,
+                                   const key_t lo, const key_t hi, key_t *arr, const size_t n)
+{
+  node_t **cur = (node_t **)malloc(s->n * sizeof(node_t *));
+  size_t *heap = (size_t *)malloc(s->n * sizeof(size_t));
+  size_t heap_n = 0, written = 0;
+
+  if (cur == NULL || heap == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+#define HEAP_KEY(i) (cur[heap[i]]->key)
+#define HEAP_SWAP(i, j) do { size_t tmp_ = heap[i]; heap[i] = heap[j]; heap[j] = tmp_; } while (0)
+
+  for (size_t i = first; i <= last; i++)
+  {
+    cur[i] = rbtree_lower_bound(s->shards[i].tree, lo);
+    if (cur[i] == NULL || cur[i]->key > hi) continue;
+
+    size_t c = heap_n++;                                 // sift up
+    heap[c] = i;
+    while (c > 0 && HEAP_KEY((c - 1) / 2) > HEAP_KEY(c))
+    {
+      HEAP_SWAP(c, (c - 1) / 2);
+      c = (c - 1) / 2;
+    }
+  }
+
+  while (heap_n > 0 && written < n)
+  {
+    const size_t i = heap[0];
+    arr[written++] = cur[i]->key;
+
+    cur[i] = rbtree_next(s->shards[i].tree, cur[i]);
+    if (cur[i] == NULL || cur[i]->key > hi) heap[0] = heap[--heap_n];
+
+    size_t p = 0;                                        // sift down
+    for (;;)
+    {
+      size_t l = 2 * p + 1, r = l + 1, m = p;
+      if (l < heap_n && HEAP_KEY(l) < HEAP_KEY(m)) m = l;
+      if (r < heap_n && HEAP_KEY(r) < HEAP_KEY(m)) m = r;
+      if (m == p) break;
+      HEAP_SWAP(p, m);
+      p = m;
+    }
+  }
+
+#undef HEAP_KEY
+#undef HEAP_SWAP
+
+  free(heap);
+  free(cur);
+  return written;
+}
+
+size_t rbtree_sharded_range(rbtree_sharded *s, const key_t lo, const key_t hi,
+                            key_t *arr, const size_t n) {
+  size_t first = 0, last = s->n - 1;
+
+  if (lo > hi) return 0;
+  if (s->mode == RBTREE_SHARD_BY_RANGE)                 // [lo, hi]와 겹치는 shard만 잠근다
+  {
+    first = (size_t)(rbtree_shard_of(s, lo) - s->shards);
+    last = (size_t)(rbtree_shard_of(s, hi) - s->shards);
+  }
+
+  rbtree_sharded_lock(s, first, last);
+  size_t written = rbtree_sharded_merge(s, first, last, lo, hi, arr, n);
+  rbtree_sharded_unlock(s, first, last);
+  return written;
+}
+
+size_t rbtree_sharded_to_array(rbtree_sharded *s, key_t *arr, const size_t n) {
+  return rbtree_sharded_range(s, INT_MIN, INT_MAX, arr, n);
+}
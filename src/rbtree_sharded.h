@@ -0,0 +1,42 @@
+#ifndef _RBTREE_SHARDED_H_
+#define _RBTREE_SHARDED_H_
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "rbtree.h"
+
+// key 공간을 N개의 독립된 rbtree로 나눈 front-end. shard마다 lock이 따로 있어
+// 서로 다른 shard로 가는 쓰기는 동시에 진행된다.
+// 한 key에 대한 연산은 shard 하나만 잠그고, 순서가 필요한 질의(min, max, to_array, range)는
+// 모든 shard를 index 순서대로 잠근 뒤 k-way merge로 합친다.
+typedef enum {
+  RBTREE_SHARD_BY_HASH,   // key의 hash로 분배 (부하가 고르게 퍼짐)
+  RBTREE_SHARD_BY_RANGE,  // key 범위를 N등분 (범위 질의가 적은 shard만 건드림)
+} rbtree_shard_mode;
+
+typedef struct {
+  rbtree *tree;
+  pthread_mutex_t lock;
+} __attribute__((aligned(64))) rbtree_shard;  // shard끼리 cache line을 공유하지 않도록 정렬
+
+typedef struct {
+  rbtree_shard *shards;
+  size_t n;
+  rbtree_shard_mode mode;
+} rbtree_sharded;
+
+rbtree_sharded *new_rbtree_sharded(const size_t, const rbtree_shard_mode);
+void delete_rbtree_sharded(rbtree_sharded *);
+
+void rbtree_sharded_insert(rbtree_sharded *, const key_t);
+int rbtree_sharded_erase(rbtree_sharded *, const key_t);
+int rbtree_sharded_contains(rbtree_sharded *, const key_t);
+
+int rbtree_sharded_min(rbtree_sharded *, key_t *);
+int rbtree_sharded_max(rbtree_sharded *, key_t *);
+size_t rbtree_sharded_size(rbtree_sharded *);
+size_t rbtree_sharded_to_array(rbtree_sharded *, key_t *, const size_t);
+size_t rbtree_sharded_range(rbtree_sharded *, const key_t, const key_t, key_t *, const size_t);
+
+#endif  // _RBTREE_SHARDED_H_
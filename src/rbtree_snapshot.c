@@ -0,0 +1,93 @@
+#include "rbtree_snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CACHE_LINE 64
+#define KEYS_PER_LINE (CACHE_LINE / sizeof(key_t))
+
+rbtree_snapshot *rbtree_freeze(const rbtree *t) {
+  rbtree_snapshot *s = (rbtree_snapshot *)calloc(1, sizeof(rbtree_snapshot));
+
+  if (s == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return rbtree_snapshot_rebuild(s, t);
+}
+
+rbtree_snapshot *rbtree_snapshot_rebuild(rbtree_snapshot *s, const rbtree *t) {
+  const size_t n = rbtree_size(t);
+
+  if (s->keys == NULL || s->cap < n)                     // 기존 배열이 충분히 크면 재사용
+  {
+    // keys[1]부터 쓰므로 한 칸 더 잡고, 64byte 단위로 정렬해 한 level의 형제들이 같은 line에 오게 한다
+    size_t bytes = ((n + 1) * sizeof(key_t) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    key_t *keys = (key_t *)aligned_alloc(CACHE_LINE, bytes);
+    if (keys == NULL)
+    {
+      fprintf(stderr, "Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    free(s->keys);
+    s->keys = keys;
+    s->cap = n;
+  }
+  s->n = n;
+
+  // 트리의 in-order 순회와 암묵적 Eytzinger 트리의 in-order 순회를 나란히 진행
+  if (n == 0) return s;
+
+  size_t k = 1;
+  while (2 * k <= n) k = 2 * k;
+  for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_next(t, p))
+  {
+    for (size_t c = rbtree_count(t, p); c > 0; c--)      // counted 트리의 node는 key 여러 개
+    {
+      s->keys[k] = p->key;
+      if (2 * k + 1 <= n)
+      {
+        k = 2 * k + 1;
+        while (2 * k <= n) k = 2 * k;
+      }
+      else
+      {
+        while (k & 1) k >>= 1;
+        k >>= 1;
+      }
+    }
+  }
+
+  return s;
+}
+
+void delete_rbtree_snapshot(rbtree_snapshot *s) {
+  if (s == NULL) return;
+
+  free(s->keys);
+  free(s);
+}
+
+const key_t *rbtree_snapshot_lower_bound(const rbtree_snapshot *s, const key_t key) {
+  const key_t *keys = s->keys;
+  const size_t n = s->n;
+  size_t k = 1;
+
+  // 분기 없이 내려가면서 4 level 아래 자손들이 있는 cache line을 미리 가져온다
+  while (k <= n)
+  {
+    __builtin_prefetch(keys + k * KEYS_PER_LINE);
+    k = 2 * k + (keys[k] < key);
+  }
+  // 마지막으로 왼쪽으로 내려간 지점이 key 이상인 첫 원소
+  k >>= __builtin_ffsll(~(unsigned long long)k);
+
+  return (k == 0) ? NULL : &keys[k];
+}
+
+const key_t *rbtree_snapshot_find(const rbtree_snapshot *s, const key_t key) {
+  const key_t *p = rbtree_snapshot_lower_bound(s, key);
+
+  return (p != NULL && *p == key) ? p : NULL;
+}
@@ -0,0 +1,23 @@
+#ifndef _RBTREE_SNAPSHOT_H_
+#define _RBTREE_SNAPSHOT_H_
+
+#include <stddef.h>
+
+#include "rbtree.h"
+
+// 읽기 전용 검색 snapshot. key를 Eytzinger(BFS) 순서로 하나의 연속된 배열에 저장한다.
+// 원래 트리에 대한 이후의 insert/erase는 반영되지 않으므로 필요할 때 다시 만든다.
+typedef struct {
+  key_t *keys;  // keys[1..n], keys[k]의 자식은 keys[2k], keys[2k + 1]
+  size_t n;
+  size_t cap;
+} rbtree_snapshot;
+
+rbtree_snapshot *rbtree_freeze(const rbtree *);
+rbtree_snapshot *rbtree_snapshot_rebuild(rbtree_snapshot *, const rbtree *);
+void delete_rbtree_snapshot(rbtree_snapshot *);
+
+const key_t *rbtree_snapshot_find(const rbtree_snapshot *, const key_t);
+const key_t *rbtree_snapshot_lower_bound(const rbtree_snapshot *, const key_t);
+
+#endif  // _RBTREE_SNAPSHOT_H_
@@ -0,0 +1,359 @@
+#include "rbtree_wal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rbtree_disk.h"
+
+#define RBTREE_WAL_BLOCK_HEADER 8                        // uint32 len + uint32 checksum
+#define RBTREE_WAL_BUFFER (RBTREE_WAL_BLOCK_HEADER + 8192 * RBTREE_WAL_RECORD)
+#define RBTREE_WAL_FNV_OFFSET 0x811c9dc5u
+#define RBTREE_WAL_FNV_PRIME 0x01000193u
+
+static uint64_t rbtree_wal_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t rbtree_wal_checksum(const unsigned char *p, size_t len)
+{
+  uint32_t h = RBTREE_WAL_FNV_OFFSET;
+
+  for (; len > 0; p++, len--) h = (h ^ *p) * RBTREE_WAL_FNV_PRIME;
+  return h;
+}
+
+static char *rbtree_wal_path(const char *path, const char *suffix)
+{
+  const size_t path_len = strlen(path), suffix_len = strlen(suffix);
+  char *p = (char *)malloc(path_len + suffix_len + 1);
+
+  if (p == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(p, path, path_len);
+  memcpy(p + path_len, suffix, suffix_len + 1);
+  return p;
+}
+
+static int rbtree_wal_write_all(const int fd, const void *buf, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)buf;
+
+  while (len > 0)
+  {
+    const ssize_t n = write(fd, p, len);
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+// 빈 log를 임시 파일에 만들어 rename 하고 디렉터리를 fsync 한다. rename 전에 실패하면 기존 log는 그대로 남는다.
+// 디렉터리 fsync를 빼면 checkpoint 직후 전원이 꺼졌을 때 이전 base의 log가 되살아나 replay에서 통째로 버려지고,
+// 그 사이 sync까지 끝난 record가 새 snapshot에도 없어 사라진다.
+static int rbtree_wal_reset(rbtree_wal *w)
+{
+  char *tmp = rbtree_wal_path(w->path, ".tmp");
+  rbtree_wal_header h;
+  int err = 0;
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, RBTREE_WAL_MAGIC, sizeof(h.magic));
+  h.version = RBTREE_WAL_VERSION;
+  h.key_size = sizeof(key_t);
+  h.base = w->base;
+
+  const int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    err = errno;
+  }
+  else if (rbtree_wal_write_all(fd, &h, sizeof(h)) != 0 || fsync(fd) != 0 || rename(tmp, w->path) != 0)
+  {
+    err = errno;
+    close(fd);
+    unlink(tmp);
+  }
+  free(tmp);
+  if (err != 0)
+  {
+    errno = err;
+    return -1;
+  }
+
+  if (w->fd >= 0) close(w->fd);
+  w->fd = fd;                                            // rename 뒤에도 같은 파일을 가리키고 위치는 header 끝
+  w->unsynced = 0;
+  return rbtree_disk_sync_dir(w->path);
+}
+
+// 모아 둔 record를 block 하나로 log에 쓴다. fsync는 하지 않는다.
+static void rbtree_wal_write_block(rbtree_wal *w)
+{
+  const size_t len = w->used - RBTREE_WAL_BLOCK_HEADER;
+
+  if (len == 0) return;
+  w->used = RBTREE_WAL_BLOCK_HEADER;
+  if (w->error != 0) return;
+
+  const uint32_t head[2] = {(uint32_t)len, rbtree_wal_checksum(w->buf + RBTREE_WAL_BLOCK_HEADER, len)};
+  memcpy(w->buf, head, sizeof(head));
+  if (rbtree_wal_write_all(w->fd, w->buf, RBTREE_WAL_BLOCK_HEADER + len) != 0)
+  {
+    w->error = errno;
+    return;
+  }
+  w->unsynced += RBTREE_WAL_BLOCK_HEADER + len;
+}
+
+int rbtree_wal_sync(rbtree_wal *w) {
+  rbtree_wal_write_block(w);
+  if (w->error == 0 && w->unsynced > 0)
+  {
+    if (fsync(w->fd) != 0)
+    {
+      w->error = errno;
+    }
+    else
+    {
+      w->unsynced = 0;
+    }
+  }
+  if (w->sync_interval_ns > 0) w->last_sync_ns = rbtree_wal_now_ns();
+
+  if (w->error == 0) return 0;
+  errno = w->error;
+  return -1;
+}
+
+static void rbtree_wal_append(rbtree_wal *w, const unsigned char op, const key_t key)
+{
+  unsigned char *p = w->buf + w->used;
+
+  p[0] = op;
+  memcpy(p + 1, &key, sizeof(key_t));
+  w->used += RBTREE_WAL_RECORD;
+
+  if (w->sync_interval_ns == 0)
+  {
+    rbtree_wal_sync(w);
+    return;
+  }
+  if (w->used + RBTREE_WAL_RECORD > RBTREE_WAL_BUFFER) rbtree_wal_write_block(w);
+  if (rbtree_wal_now_ns() - w->last_sync_ns >= w->sync_interval_ns) rbtree_wal_sync(w);
+}
+
+static void rbtree_wal_apply(rbtree *t, const unsigned char op, const key_t key)
+{
+  if (op == RBTREE_WAL_INSERT)
+  {
+    rbtree_insert(t, key);
+    return;
+  }
+  node_t *p = rbtree_find(t, key);
+  if (p != NULL) rbtree_erase(t, p);
+}
+
+// log 전체를 읽어 header를 확인하고 온전한 block을 순서대로 트리에 적용한다.
+// 쓰다 끊긴 마지막 부분은 잘라낸다. 이전 snapshot에 대한 log이거나 빈 파일이면 새 log로 바꾼다.
+static int rbtree_wal_replay(rbtree_wal *w)
+{
+  struct stat st;
+  unsigned char *data = NULL;
+
+  if (fstat(w->fd, &st) != 0) return -1;
+  const size_t size = (size_t)st.st_size;
+  rbtree_wal_header h;
+
+  if (size < sizeof(h)) return rbtree_wal_reset(w);     // 만들다 중단된 log에는 적용할 record가 없다
+
+  data = (unsigned char *)malloc(size);
+  if (data == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t off = 0; off < size;)
+  {
+    const ssize_t n = pread(w->fd, data + off, size - off, (off_t)off);
+    if (n <= 0)
+    {
+      if (n < 0 && errno == EINTR) continue;
+      if (n == 0) errno = EIO;
+      free(data);
+      return -1;
+    }
+    off += (size_t)n;
+  }
+
+  memcpy(&h, data, sizeof(h));
+  if (memcmp(h.magic, RBTREE_WAL_MAGIC, sizeof(h.magic)) != 0 || h.version != RBTREE_WAL_VERSION ||
+      h.key_size != sizeof(key_t))
+  {
+    free(data);
+    errno = EINVAL;
+    return -1;
+  }
+  if (h.base != w->base)
+  {
+    free(data);
+    return rbtree_wal_reset(w);
+  }
+
+  size_t off = sizeof(h);
+  while (size - off >= RBTREE_WAL_BLOCK_HEADER)
+  {
+    uint32_t head[2];
+    memcpy(head, data + off, sizeof(head));
+    const size_t len = head[0];
+    const unsigned char *rec = data + off + RBTREE_WAL_BLOCK_HEADER;
+
+    if (len == 0 || len % RBTREE_WAL_RECORD != 0 || len > size - off - RBTREE_WAL_BLOCK_HEADER) break;
+    if (rbtree_wal_checksum(rec, len) != head[1]) break;
+
+    for (size_t i = 0; i < len; i += RBTREE_WAL_RECORD)
+    {
+      key_t key;
+      memcpy(&key, rec + i + 1, sizeof(key_t));
+      rbtree_wal_apply(w->tree, rec[i], key);
+    }
+    off += RBTREE_WAL_BLOCK_HEADER + len;
+  }
+  free(data);
+
+  if (off < size && (ftruncate(w->fd, (off_t)off) != 0 || fsync(w->fd) != 0)) return -1;
+  if (lseek(w->fd, (off_t)off, SEEK_SET) < 0) return -1;
+  return 0;
+}
+
+static void rbtree_wal_free(rbtree_wal *w)
+{
+  if (w->fd >= 0) close(w->fd);
+  delete_rbtree(w->tree);
+  free(w->buf);
+  free(w->snap_path);
+  free(w->path);
+  free(w);
+}
+
+rbtree_wal *rbtree_wal_open(const char *path, const uint64_t sync_interval_us) {
+  rbtree_wal *w = (rbtree_wal *)calloc(1, sizeof(rbtree_wal));
+  if (w == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  w->fd = -1;
+  w->path = rbtree_wal_path(path, "");
+  w->snap_path = rbtree_wal_path(path, ".snap");
+  w->sync_interval_ns = sync_interval_us * 1000;
+  w->buf = (unsigned char *)malloc(RBTREE_WAL_BUFFER);
+  if (w->buf == NULL)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  w->used = RBTREE_WAL_BLOCK_HEADER;
+
+  rbtree_mapped *m = rbtree_load_mmap(w->snap_path);
+  if (m != NULL)
+  {
+    w->base = m->header->checksum;
+    w->tree = rbtree_mapped_detach(m);
+  }
+  else if (errno == ENOENT)
+  {
+    w->tree = new_rbtree();
+  }
+  else
+  {
+    goto fail;
+  }
+
+  // 여기서 새로 만든 log는 비어 있으므로 replay가 rbtree_wal_reset으로 바꾸고 디렉터리까지 fsync 한다
+  w->fd = open(w->path, O_RDWR | O_CREAT, 0644);
+  if (w->fd < 0 || rbtree_wal_replay(w) != 0) goto fail;
+  w->last_sync_ns = rbtree_wal_now_ns();
+  return w;
+
+fail:;
+  const int err = errno;
+  rbtree_wal_free(w);
+  errno = err;
+  return NULL;
+}
+
+int rbtree_wal_close(rbtree_wal *w) {
+  const int ret = rbtree_wal_sync(w);
+  const int err = errno;
+
+  rbtree_wal_free(w);
+  errno = err;
+  return ret;
+}
+
+node_t *rbtree_wal_insert(rbtree_wal *w, const key_t key) {
+  if (w->error == 0) rbtree_wal_append(w, RBTREE_WAL_INSERT, key);
+  if (w->error != 0)                                     // log에 남지 않은 연산은 트리에도 적용하지 않는다
+  {
+    errno = w->error;
+    return NULL;
+  }
+  return rbtree_insert(w->tree, key);
+}
+
+int rbtree_wal_erase(rbtree_wal *w, const key_t key) {
+  node_t *p = rbtree_find(w->tree, key);
+
+  if (w->error == 0 && p != NULL) rbtree_wal_append(w, RBTREE_WAL_ERASE, key);
+  if (w->error != 0)
+  {
+    errno = w->error;
+    return -1;
+  }
+  if (p == NULL) return 0;
+  rbtree_erase(w->tree, p);
+  return 1;
+}
+
+int rbtree_wal_checkpoint(rbtree_wal *w) {
+  // log를 먼저 sync 해 두어야 snapshot만 바뀐 채 중단되어도 버려지는 log가 모두 snapshot에 들어 있다
+  if (rbtree_wal_sync(w) != 0 || rbtree_save(w->tree, w->snap_path) != 0) return -1;
+
+  rbtree_disk_header h;
+  const int fd = open(w->snap_path, O_RDONLY);
+  if (fd < 0) return -1;
+  const ssize_t n = pread(fd, &h, sizeof(h), 0);
+  const int err = errno;
+  close(fd);
+  if (n != (ssize_t)sizeof(h))
+  {
+    errno = (n < 0) ? err : EIO;
+    return -1;
+  }
+
+  // 여기서 log를 바꾸지 못하면 이후 record가 이전 base의 log에 쌓여 open 때 버려지므로 더 쓰지 않는다
+  w->base = h.checksum;
+  if (rbtree_wal_reset(w) != 0)
+  {
+    w->error = errno;
+    return -1;
+  }
+  return 0;
+}
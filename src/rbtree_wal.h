@@ -0,0 +1,67 @@
+#ifndef _RBTREE_WAL_H_
+#define _RBTREE_WAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rbtree.h"
+
+// rbtree에 붙여 쓰는 write-ahead log.
+//
+//   log:      [rbtree_wal_header][block]...
+//   block:    [uint32 len][uint32 checksum][record x (len / RBTREE_WAL_RECORD)]
+//   record:   [op 1byte][key]
+//   snapshot: <log 경로>.snap, rbtree_save 형식
+//
+// insert/erase는 record를 메모리 buffer에 붙이기만 하고, 모인 record는 block 하나로 write + fsync 한다(group commit).
+// block마다 checksum이 있어 쓰다 끊긴 마지막 block은 replay 때 버리고 log를 그 앞까지 잘라낸다.
+// checkpoint는 트리를 snapshot으로 저장한 뒤 빈 log로 바꾼다. log header의 base는 log가 이어지는 snapshot의
+// checksum이므로, snapshot을 바꾼 직후 중단되어 남은 이전 log는 open 때 이미 반영된 것으로 보고 버린다.
+
+#define RBTREE_WAL_MAGIC "RBTREWAL"
+#define RBTREE_WAL_VERSION 1
+#define RBTREE_WAL_INSERT 'I'
+#define RBTREE_WAL_ERASE 'E'
+#define RBTREE_WAL_RECORD (1 + sizeof(key_t))
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;   // sizeof(key_t)
+  uint64_t base;       // 이 log가 이어지는 snapshot의 checksum, snapshot이 없으면 0
+} rbtree_wal_header;
+
+typedef struct {
+  rbtree *tree;        // 읽기는 tree에 바로 하고, 쓰기는 rbtree_wal_insert/erase로 한다
+  int fd;
+  char *path, *snap_path;
+  uint64_t base;
+
+  uint64_t sync_interval_ns;
+  uint64_t last_sync_ns;
+  unsigned char *buf;  // 아직 log에 쓰지 않은 record
+  size_t used;
+  size_t unsynced;     // log에 썼지만 fsync 하지 않은 byte
+  int error;           // 처음 실패한 I/O의 errno, 이후의 sync는 모두 실패한다
+} rbtree_wal;
+
+// path의 snapshot과 log로 트리를 복구해서 연다. 둘 다 없으면 빈 트리로 시작한다.
+// sync_interval_us가 0이면 연산마다 fsync 하고, 아니면 마지막 fsync 후 그 시간이 지난 연산에서 모아서 fsync 한다.
+// 실패하면 NULL을 반환하고 errno를 남긴다.
+rbtree_wal *rbtree_wal_open(const char *, const uint64_t);
+// 남은 record를 sync 하고 트리까지 해제한다. 성공하면 0, 실패하면 -1.
+int rbtree_wal_close(rbtree_wal *);
+
+// log가 한 번이라도 실패했거나 이번 연산의 write/fsync가 실패하면 트리를 바꾸지 않고 NULL을 반환하며 errno를 남긴다.
+// sync_interval_us가 0이면 성공한 연산은 이미 fsync 된 것이다. 아니면 마지막 sync 뒤의 연산은 아직 내구성이 없으므로
+// 그 연산들이 남았는지는 rbtree_wal_sync의 결과로 확인한다.
+node_t *rbtree_wal_insert(rbtree_wal *, const key_t);
+// key를 가진 node 하나를 지운다. 없으면 log에 남기지 않고 0, 지웠으면 1, log가 실패했으면 -1 (insert와 같다).
+int rbtree_wal_erase(rbtree_wal *, const key_t);
+
+// 지금까지의 연산을 모두 fsync 한다. 연산이 뜸할 때 interval을 기다리지 않고 내구성을 확보하려면 직접 부른다.
+int rbtree_wal_sync(rbtree_wal *);
+// 트리를 snapshot으로 저장하고 log를 비운다. 새 log로 바꾸는 데 실패하면 이후의 연산은 모두 실패한다.
+int rbtree_wal_checkpoint(rbtree_wal *);
+
+#endif  // _RBTREE_WAL_H_
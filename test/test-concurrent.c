@@ -0,0 +1,105 @@
+#include <assert.h>
+#include <pthread.h>
+#include <rbtree_concurrent.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STABLE_KEYS 4096    // even keys 0, 2, ..., 2 * (STABLE_KEYS - 1), never erased
+#define WRITERS 4
+#define READERS 4
+#define WRITER_OPS 20000
+#define READER_OPS 200000
+
+static crbtree *tree;
+
+typedef struct {
+  int id;
+  size_t live;  // odd keys this writer left in the tree
+} writer_arg;
+
+// writers insert and erase odd keys in their own slice of the key space
+static void *writer(void *p) {
+  writer_arg *arg = (writer_arg *)p;
+  unsigned int seed = arg->id;
+  const int slice = 2 * STABLE_KEYS / WRITERS;
+  char *present = calloc(slice, 1);
+
+  for (int i = 0; i < WRITER_OPS; i++) {
+    int j = rand_r(&seed) % (slice / 2);
+    key_t key = arg->id * slice + 2 * j + 1;
+    if (present[j]) {
+      assert(crbtree_erase(tree, key));
+      present[j] = 0;
+      arg->live--;
+    } else {
+      crbtree_insert(tree, key);
+      present[j] = 1;
+      arg->live++;
+    }
+  }
+  free(present);
+  return NULL;
+}
+
+// readers should always see the stable keys and never see keys that were
+// never inserted, whatever the writers are doing
+static void *reader(void *p) {
+  unsigned int seed = (unsigned int)(size_t)p;
+
+  for (int i = 0; i < READER_OPS; i++) {
+    key_t key = 2 * (rand_r(&seed) % STABLE_KEYS);
+    assert(crbtree_contains(tree, key));
+    assert(!crbtree_contains(tree, -1 - key));
+
+    key_t lb;
+    key_t probe = key - 1;
+    if (probe >= 0) {
+      assert(crbtree_lower_bound(tree, probe, &lb));
+      assert(lb == probe || lb == key);
+    }
+  }
+  return NULL;
+}
+
+void test_concurrent_stress(void) {
+  tree = new_crbtree();
+  for (key_t key = 0; key < 2 * STABLE_KEYS; key += 2) {
+    crbtree_insert(tree, key);
+  }
+  assert(crbtree_size(tree) == STABLE_KEYS);
+
+  pthread_t w[WRITERS], r[READERS];
+  writer_arg args[WRITERS];
+  for (int i = 0; i < READERS; i++) {
+    pthread_create(&r[i], NULL, reader, (void *)(size_t)(i + 100));
+  }
+  for (int i = 0; i < WRITERS; i++) {
+    args[i].id = i;
+    args[i].live = 0;
+    pthread_create(&w[i], NULL, writer, &args[i]);
+  }
+  size_t live = 0;
+  for (int i = 0; i < WRITERS; i++) {
+    pthread_join(w[i], NULL);
+    live += args[i].live;
+  }
+  for (int i = 0; i < READERS; i++) {
+    pthread_join(r[i], NULL);
+  }
+
+  const size_t n = crbtree_size(tree);
+  assert(n == STABLE_KEYS + live);
+  key_t *arr = calloc(n, sizeof(key_t));
+  assert(crbtree_to_array(tree, arr, n) == n);
+  for (int i = 1; i < n; i++) {
+    assert(arr[i - 1] < arr[i]);
+  }
+
+  free(arr);
+  delete_crbtree(tree);
+}
+
+int main(void) {
+  test_concurrent_stress();
+  printf("Passed all tests!\n");
+}
@@ -0,0 +1,68 @@
+#include <assert.h>
+#include <pthread.h>
+#include <rbtree_deferred.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THREADS 4
+#define TREES_PER_THREAD 16
+
+static rbtree *make_tree(const size_t n, const int counted) {
+  rbtree *t = counted ? new_rbtree_counted() : new_rbtree();
+  for (size_t i = 0; i < n; i++) {
+    rbtree_insert(t, (key_t)(rand() % 1000));
+  }
+  // erase some so that the free list is not empty when the tree is dropped
+  for (size_t i = 0; i < n / 4; i++) {
+    rbtree_erase(t, t->root);
+  }
+  return t;
+}
+
+static void *drop_trees(void *arg) {
+  rbtree **trees = arg;
+  for (int i = 0; i < TREES_PER_THREAD; i++) {
+    rbtree_delete_deferred(trees[i]);
+  }
+  return NULL;
+}
+
+// trees dropped from several threads at once are all freed by the time flush returns
+void test_concurrent_drop(void) {
+  rbtree *trees[THREADS][TREES_PER_THREAD];
+  pthread_t threads[THREADS];
+
+  for (int i = 0; i < THREADS; i++) {
+    for (int j = 0; j < TREES_PER_THREAD; j++) {
+      trees[i][j] = make_tree((size_t)(rand() % 5000), j % 3 == 0);
+    }
+  }
+  for (int i = 0; i < THREADS; i++) {
+    assert(pthread_create(&threads[i], NULL, drop_trees, trees[i]) == 0);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  rbtree_deferred_flush();
+}
+
+// the background thread stays around after a flush and keeps taking trees
+void test_drop_after_flush(void) {
+  rbtree_deferred_flush();
+  rbtree_delete_deferred(NULL);
+  rbtree_deferred_flush();
+
+  for (int i = 0; i < 3; i++) {
+    rbtree_delete_deferred(make_tree(100000, 0));
+    rbtree_delete_deferred(new_rbtree());
+    rbtree_deferred_flush();
+  }
+}
+
+int main(void) {
+  srand(61);
+  test_drop_after_flush();
+  test_concurrent_drop();
+  test_drop_after_flush();
+  printf("Passed all tests!\n");
+}
@@ -0,0 +1,170 @@
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <rbtree_disk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char path[64];
+
+static void make_path(void) {
+  snprintf(path, sizeof(path), "/tmp/test-disk-%d.rbt", (int)getpid());
+}
+
+// every read on the mapping should match the tree that was saved
+static void check_same(const rbtree_mapped *m, const rbtree *t) {
+  const size_t n = rbtree_size(t);
+  assert(rbtree_mapped_size(m) == n);
+
+  key_t *a = calloc(n + 1, sizeof(key_t));
+  key_t *b = calloc(n + 1, sizeof(key_t));
+  assert(rbtree_mapped_range(m, INT_MIN, INT_MAX, a, n) == n);
+  rbtree_to_array(t, b, n);
+  for (int i = 0; i < n; i++) {
+    assert(a[i] == b[i]);
+  }
+
+  for (key_t key = -10; key < 2010; key++) {
+    assert(rbtree_mapped_contains(m, key) == (rbtree_find(t, key) != NULL));
+    key_t got;
+    node_t *p = rbtree_lower_bound(t, key);
+    assert(rbtree_mapped_lower_bound(m, key, &got) == (p != NULL));
+    assert(p == NULL || got == p->key);
+  }
+
+  const size_t got = rbtree_mapped_range(m, 100, 300, a, n);
+  assert(got == rbtree_range(t, 100, 300, b, n));
+  for (int i = 0; i < got; i++) {
+    assert(a[i] == b[i]);
+  }
+  assert(rbtree_mapped_range(m, 100, 300, a, 2) == (got < 2 ? got : 2));
+  assert(rbtree_mapped_range(m, 300, 100, a, n) == 0);
+
+  free(b);
+  free(a);
+}
+
+void test_save_load(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++) {
+    rbtree_insert(t, rand() % 2000);
+  }
+
+  assert(rbtree_save(t, path) == 0);
+  rbtree_mapped *m = rbtree_load_mmap(path);
+  assert(m != NULL && m->tree == NULL);
+  check_same(m, t);
+
+  // a missing key does not promote the mapping
+  assert(rbtree_mapped_erase(m, 5000) == 0);
+  assert(m->tree == NULL);
+
+  // the first write copies the mapping into a mutable tree
+  rbtree_mapped_insert(m, 5000);
+  rbtree_insert(t, 5000);
+  assert(m->tree != NULL && m->map == NULL);
+  if (n > 0) {
+    const key_t key = rbtree_min(t)->key;
+    assert(rbtree_mapped_erase(m, key) == 1);
+    rbtree_erase(t, rbtree_find(t, key));
+  }
+  check_same(m, t);
+  delete_rbtree_mapped(m);
+
+  // writes never reach the file
+  m = rbtree_load_mmap(path);
+  assert(m != NULL);
+  assert(rbtree_mapped_size(m) == n);
+  assert(!rbtree_mapped_contains(m, 5000));
+  delete_rbtree_mapped(m);
+
+  unlink(path);
+  delete_rbtree(t);
+}
+
+static void flip_byte(const long offset) {
+  FILE *f = fopen(path, "r+b");
+  assert(f != NULL);
+  assert(fseek(f, offset, SEEK_SET) == 0);
+  int c = fgetc(f);
+  assert(c != EOF);
+  assert(fseek(f, offset, SEEK_SET) == 0);
+  fputc(c ^ 0x40, f);
+  fclose(f);
+}
+
+// damaged, truncated or foreign files are rejected
+void test_load_invalid(void) {
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < 1000; i++) {
+    rbtree_insert(t, i);
+  }
+  const long node_bytes = (long)sizeof(rbtree_disk_node);
+  const long header_bytes = (long)sizeof(rbtree_disk_header);
+
+  assert(rbtree_load_mmap("/tmp/no-such-dir/tree.rbt") == NULL);
+  assert(rbtree_save(t, "/tmp/no-such-dir/tree.rbt") == -1);
+
+  // the format has no room for multiplicities
+  rbtree *c = new_rbtree_counted();
+  rbtree_insert(c, 1);
+  assert(rbtree_save(c, path) == -1 && errno == EINVAL);
+  assert(access(path, F_OK) != 0);
+  delete_rbtree(c);
+
+  assert(rbtree_save(t, path) == 0);
+  flip_byte(header_bytes + 500 * node_bytes + 4);  // a key in the middle
+  assert(rbtree_load_mmap(path) == NULL);
+
+  assert(rbtree_save(t, path) == 0);
+  flip_byte(0);  // magic
+  assert(rbtree_load_mmap(path) == NULL);
+
+  assert(rbtree_save(t, path) == 0);
+  assert(truncate(path, header_bytes + 999 * node_bytes) == 0);
+  assert(rbtree_load_mmap(path) == NULL);
+
+  assert(truncate(path, 0) == 0);
+  assert(rbtree_load_mmap(path) == NULL);
+
+  // saving over an existing file replaces it
+  assert(rbtree_save(t, path) == 0);
+  rbtree_mapped *m = rbtree_load_mmap(path);
+  assert(m != NULL && rbtree_mapped_size(m) == 1000);
+  delete_rbtree_mapped(m);
+
+  unlink(path);
+  delete_rbtree(t);
+}
+
+// a mapping whose child links loop back must not hang a lookup
+void test_cyclic_links(void) {
+  rbtree_disk_header h = {.count = 3, .root = 1};
+  rbtree_disk_node nodes[3] = {
+      {.left = RBTREE_DISK_NIL, .right = 1, .key = 10},  // points back up at the root
+      {.left = 0, .right = 2, .key = 20},
+      {.left = RBTREE_DISK_NIL, .right = 0, .key = 30},  // points back below the root
+  };
+  rbtree_mapped m = {.header = &h, .nodes = nodes};
+  key_t out;
+
+  assert(!rbtree_mapped_contains(&m, 15));
+  assert(rbtree_mapped_lower_bound(&m, 15, &out) && out == 20);
+  assert(!rbtree_mapped_contains(&m, 35));
+  assert(!rbtree_mapped_lower_bound(&m, 35, &out));
+  assert(rbtree_mapped_contains(&m, 10) && rbtree_mapped_contains(&m, 30));
+}
+
+int main(void) {
+  make_path();
+  test_save_load(0, 1);
+  test_save_load(1, 2);
+  test_save_load(100, 3);
+  test_save_load(10000, 4);
+  test_load_invalid();
+  test_cyclic_links();
+  printf("Passed all tests!\n");
+}
@@ -0,0 +1,100 @@
+#include <assert.h>
+#include <rbtree_generic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STR_CMP(a, b) strcmp((a), (b))
+
+RBTREE_DEFINE(itree, int, double, RBTREE_CMP_SCALAR)
+RBTREE_DEFINE(stree, const char *, int, STR_CMP)
+
+// values should be stored inline and found by key
+void test_int_double(void) {
+  itree *t = itree_new();
+  assert(t != NULL);
+  assert(itree_size(t) == 0);
+  assert(itree_min(t) == NULL);
+
+  const int keys[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12};
+  const size_t n = sizeof(keys) / sizeof(keys[0]);
+  for (int i = 0; i < n; i++) {
+    itree_insert(t, keys[i], keys[i] * 0.5);
+  }
+  assert(itree_size(t) == n);
+
+  for (int i = 0; i < n; i++) {
+    itree_node *p = itree_find(t, keys[i]);
+    assert(p != NULL);
+    assert(p->key == keys[i]);
+    assert(p->value == keys[i] * 0.5);
+  }
+  assert(itree_find(t, 1000) == NULL);
+  assert(itree_min(t)->key == 2);
+  assert(itree_max(t)->key == 156);
+
+  itree_erase(t, itree_find(t, 23));
+  assert(itree_find(t, 23) == NULL);
+  assert(itree_size(t) == n - 1);
+
+  itree_delete(t);
+}
+
+// ordered iteration should follow the comparator
+void test_string_keys(void) {
+  stree *t = stree_new();
+  const char *words[] = {"pear", "apple", "fig", "kiwi", "banana", "apple"};
+  const size_t n = sizeof(words) / sizeof(words[0]);
+  for (int i = 0; i < n; i++) {
+    stree_insert(t, words[i], i);
+  }
+
+  const char *sorted[] = {"apple", "apple", "banana", "fig", "kiwi", "pear"};
+  int i = 0;
+  for (stree_node *p = stree_min(t); p != NULL; p = stree_next(t, p)) {
+    assert(strcmp(p->key, sorted[i++]) == 0);
+  }
+  assert(i == n);
+  for (stree_node *p = stree_max(t); p != NULL; p = stree_prev(t, p)) {
+    assert(strcmp(p->key, sorted[--i]) == 0);
+  }
+
+  assert(stree_find(t, "kiwi")->value == 3);
+  stree_delete(t);
+}
+
+// random insert/erase should keep the keys in order
+void test_random(const size_t n, const unsigned int seed) {
+  srand(seed);
+  itree *t = itree_new();
+  int *arr = calloc(n, sizeof(int));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % 1000;
+    itree_insert(t, arr[i], i);
+  }
+  for (int i = 0; i < n; i += 2) {
+    itree_node *p = itree_find(t, arr[i]);
+    assert(p != NULL);
+    itree_erase(t, p);
+  }
+  assert(itree_size(t) == n / 2);
+
+  size_t count = 0;
+  int prev = -1;
+  for (itree_node *p = itree_min(t); p != NULL; p = itree_next(t, p)) {
+    assert(prev <= p->key);
+    prev = p->key;
+    count++;
+  }
+  assert(count == n / 2);
+
+  free(arr);
+  itree_delete(t);
+}
+
+int main(void) {
+  test_int_double();
+  test_string_keys();
+  test_random(10000, 3);
+  printf("Passed all tests!\n");
+}
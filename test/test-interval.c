@@ -0,0 +1,141 @@
+#include <assert.h>
+#include <rbtree_interval.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  key_t lo, hi;
+} interval_t;
+
+// checks the red-black properties, lo order and max_hi, returns the black height
+static int check_subtree(const rbtree_interval *t, const ivnode_t *x) {
+  if (x == t->nil) {
+    return 1;
+  }
+  key_t m = x->hi;
+  if (x->left != t->nil) {
+    assert(x->left->parent == x && x->left->lo <= x->lo);
+    m = x->left->max_hi > m ? x->left->max_hi : m;
+  }
+  if (x->right != t->nil) {
+    assert(x->right->parent == x && x->right->lo >= x->lo);
+    m = x->right->max_hi > m ? x->right->max_hi : m;
+  }
+  assert(x->max_hi == m);
+  if (x->color == RBTREE_RED) {
+    assert(x->left->color == RBTREE_BLACK && x->right->color == RBTREE_BLACK);
+  }
+  const int hl = check_subtree(t, x->left);
+  assert(hl == check_subtree(t, x->right));
+  return hl + (x->color == RBTREE_BLACK);
+}
+
+typedef struct {
+  interval_t *out;
+  size_t n, limit;
+} collect_t;
+
+static int collect(ivnode_t *x, void *arg) {
+  collect_t *c = arg;
+  c->out[c->n].lo = x->lo;
+  c->out[c->n].hi = x->hi;
+  c->n++;
+  return c->n == c->limit;
+}
+
+static int cmp_interval(const void *a, const void *b) {
+  const interval_t *x = a, *y = b;
+  if (x->lo != y->lo) {
+    return (x->lo > y->lo) - (x->lo < y->lo);
+  }
+  return (x->hi > y->hi) - (x->hi < y->hi);
+}
+
+// every overlap query returns exactly what a linear scan finds, in lo order
+static void check_queries(const rbtree_interval *t, const interval_t *all, const size_t n) {
+  interval_t *got = calloc(n + 1, sizeof(interval_t));
+  interval_t *expected = calloc(n + 1, sizeof(interval_t));
+
+  for (int q = 0; q < 200; q++) {
+    const key_t a = rand() % 1100 - 50;
+    const key_t b = a + rand() % (q % 2 ? 5 : 200);
+    size_t m = 0;
+    for (int i = 0; i < n; i++) {
+      if (all[i].lo <= b && a <= all[i].hi) {
+        expected[m++] = all[i];
+      }
+    }
+    collect_t c = {.out = got, .limit = 0};
+    assert(rbtree_interval_overlaps(t, a, b, collect, &c) == m && c.n == m);
+    for (int i = 1; i < m; i++) {
+      assert(got[i - 1].lo <= got[i].lo);
+    }
+    qsort(expected, m, sizeof(interval_t), cmp_interval);
+    qsort(got, m, sizeof(interval_t), cmp_interval);
+    for (int i = 0; i < m; i++) {
+      assert(got[i].lo == expected[i].lo && got[i].hi == expected[i].hi);
+    }
+
+    // the callback can stop the walk early
+    if (m > 2) {
+      c.n = 0;
+      c.limit = 2;
+      assert(rbtree_interval_overlaps(t, a, b, collect, &c) == 2);
+    }
+  }
+  assert(rbtree_interval_overlaps(t, 10, 5, collect, &(collect_t){.out = got}) == 0);
+
+  free(expected);
+  free(got);
+}
+
+void test_interval(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree_interval *t = new_rbtree_interval();
+  interval_t *all = calloc(n + 1, sizeof(interval_t));
+  size_t m = 0;
+
+  assert(rbtree_interval_insert(t, 5, 4) == NULL);
+  for (int i = 0; i < n; i++) {
+    const key_t lo = rand() % 1000;
+    const key_t hi = lo + (rand() % 10 == 0 ? rand() % 300 : rand() % 10);
+    ivnode_t *x = rbtree_interval_insert(t, lo, hi);
+    assert(x->lo == lo && x->hi == hi);
+    all[m++] = (interval_t){lo, hi};
+  }
+  assert(rbtree_interval_size(t) == m);
+  check_subtree(t, t->root);
+  check_queries(t, all, m);
+
+  // erase about half of them, including duplicates
+  for (int i = 0; i < n / 2; i++) {
+    const size_t j = rand() % m;
+    ivnode_t *x = rbtree_interval_find(t, all[j].lo, all[j].hi);
+    assert(x != NULL && x->lo == all[j].lo && x->hi == all[j].hi);
+    rbtree_interval_erase(t, x);
+    all[j] = all[--m];
+    if (i % 64 == 0) {
+      check_subtree(t, t->root);
+    }
+  }
+  assert(rbtree_interval_size(t) == m);
+  assert(rbtree_interval_find(t, 2000, 2001) == NULL);
+  check_subtree(t, t->root);
+  check_queries(t, all, m);
+
+  while (m > 0) {
+    m--;
+    rbtree_interval_erase(t, rbtree_interval_find(t, all[m].lo, all[m].hi));
+  }
+  assert(t->root == t->nil && rbtree_interval_size(t) == 0);
+
+  free(all);
+  delete_rbtree_interval(t);
+}
+
+int main(void) {
+  test_interval(1, 1);
+  test_interval(100, 2);
+  test_interval(5000, 3);
+  printf("Passed all tests!\n");
+}
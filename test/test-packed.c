@@ -0,0 +1,160 @@
+#include <assert.h>
+#include <rbtree_packed.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int comp(const void *p1, const void *p2) {
+  const key_t *e1 = (const key_t *)p1;
+  const key_t *e2 = (const key_t *)p2;
+  return (*e1 > *e2) - (*e1 < *e2);
+}
+
+// returns the black height of the subtree, or -1 if a constraint is broken
+static int pnode_check(const pnode_t *p, const pnode_t *parent) {
+  if (p == NULL) {
+    return 1;
+  }
+  if (PRBTREE_PARENT(p) != parent) {
+    return -1;
+  }
+  if (PRBTREE_COLOR(p) == RBTREE_RED &&
+      ((p->left && PRBTREE_COLOR(p->left) == RBTREE_RED) ||
+       (p->right && PRBTREE_COLOR(p->right) == RBTREE_RED))) {
+    return -1;
+  }
+  if ((p->left && p->left->key > p->key) ||
+      (p->right && p->right->key < p->key)) {
+    return -1;
+  }
+  const int l = pnode_check(p->left, p);
+  const int r = pnode_check(p->right, p);
+  if (l < 0 || l != r) {
+    return -1;
+  }
+  return l + (PRBTREE_COLOR(p) == RBTREE_BLACK);
+}
+
+static int inode_check(const irbtree *t, inode_id i, inode_id parent) {
+  if (i == IRBTREE_NIL) {
+    return 1;
+  }
+  const inode_t *p = &t->nodes[i];
+  if (IRBTREE_PARENT(t, i) != parent) {
+    return -1;
+  }
+  if (IRBTREE_COLOR(t, i) == RBTREE_RED &&
+      ((p->left && IRBTREE_COLOR(t, p->left) == RBTREE_RED) ||
+       (p->right && IRBTREE_COLOR(t, p->right) == RBTREE_RED))) {
+    return -1;
+  }
+  if ((p->left && IRBTREE_KEY(t, p->left) > p->key) ||
+      (p->right && IRBTREE_KEY(t, p->right) < p->key)) {
+    return -1;
+  }
+  const int l = inode_check(t, p->left, i);
+  const int r = inode_check(t, p->right, i);
+  if (l < 0 || l != r) {
+    return -1;
+  }
+  return l + (IRBTREE_COLOR(t, i) == RBTREE_BLACK);
+}
+
+// the pointer-packed tree should keep the rbtree constraints through
+// random inserts and erases
+void test_prbtree(const size_t n, const unsigned int seed) {
+  srand(seed);
+  prbtree *t = new_prbtree();
+  assert(prbtree_min(t) == NULL);
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % (n / 2 + 1);
+    pnode_t *p = prbtree_insert(t, arr[i]);
+    assert(p != NULL && p->key == arr[i]);
+  }
+  assert(t->size == n);
+  assert(PRBTREE_COLOR(t->root) == RBTREE_BLACK);
+  assert(pnode_check(t->root, NULL) > 0);
+
+  size_t m = 0;
+  for (int i = 0; i < n; i++) {
+    pnode_t *p = prbtree_find(t, arr[i]);
+    assert(p != NULL && p->key == arr[i]);
+    if (i % 2 == 0) {
+      prbtree_erase(t, p);
+    } else {
+      arr[m++] = arr[i];
+    }
+  }
+  assert(t->size == m);
+  assert(pnode_check(t->root, NULL) > 0);
+
+  qsort(arr, m, sizeof(key_t), comp);
+  key_t *res = calloc(m, sizeof(key_t));
+  assert(prbtree_to_array(t, res, m) == m);
+  for (int i = 0; i < m; i++) {
+    assert(res[i] == arr[i]);
+  }
+  assert(prbtree_min(t)->key == arr[0]);
+  assert(prbtree_max(t)->key == arr[m - 1]);
+
+  free(res);
+  free(arr);
+  delete_prbtree(t);
+}
+
+// the index-linked tree should behave like the pointer tree
+void test_irbtree(const size_t n, const unsigned int seed) {
+  srand(seed);
+  irbtree *t = new_irbtree();
+  assert(irbtree_min(t) == IRBTREE_NIL);
+  assert(irbtree_find(t, 1) == IRBTREE_NIL);
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % (n / 2 + 1);
+    inode_id id = irbtree_insert(t, arr[i]);
+    assert(id != IRBTREE_NIL && IRBTREE_KEY(t, id) == arr[i]);
+  }
+  assert(t->size == n);
+  assert(inode_check(t, t->root, IRBTREE_NIL) > 0);
+
+  size_t m = 0;
+  for (int i = 0; i < n; i++) {
+    inode_id id = irbtree_find(t, arr[i]);
+    assert(id != IRBTREE_NIL && IRBTREE_KEY(t, id) == arr[i]);
+    if (i % 2 == 0) {
+      irbtree_erase(t, id);
+    } else {
+      arr[m++] = arr[i];
+    }
+  }
+  assert(t->size == m);
+  assert(inode_check(t, t->root, IRBTREE_NIL) > 0);
+
+  qsort(arr, m, sizeof(key_t), comp);
+  key_t *res = calloc(m, sizeof(key_t));
+  assert(irbtree_to_array(t, res, m) == m);
+  for (int i = 0; i < m; i++) {
+    assert(res[i] == arr[i]);
+  }
+  size_t i = 0;
+  for (inode_id id = irbtree_min(t); id != IRBTREE_NIL; id = irbtree_next(t, id)) {
+    assert(IRBTREE_KEY(t, id) == arr[i++]);
+  }
+  assert(i == m);
+
+  // erased slots should be reused before the array grows
+  const uint32_t used = t->used;
+  irbtree_insert(t, 42);
+  assert(t->used == used);
+
+  free(res);
+  free(arr);
+  delete_irbtree(t);
+}
+
+int main(void) {
+  assert(sizeof(inode_t) == 16);
+  test_prbtree(10000, 11);
+  test_irbtree(10000, 13);
+  printf("Passed all tests!\n");
+}
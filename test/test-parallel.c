@@ -0,0 +1,322 @@
+#include <assert.h>
+#include <rbtree_parallel.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int comp(const void *p1, const void *p2) {
+  const key_t *e1 = (const key_t *)p1;
+  const key_t *e2 = (const key_t *)p2;
+  if (*e1 < *e2) {
+    return -1;
+  } else if (*e1 > *e2) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+// returns the black height of p, and checks order, colors, sizes and parent links
+static int check_subtree(const rbtree *t, const node_t *p, const node_t *parent,
+                         const key_t *lo, const key_t *hi) {
+  if (p == t->nil) {
+    return 0;
+  }
+  assert(p->parent == parent);
+  assert(lo == NULL || *lo <= p->key);
+  assert(hi == NULL || p->key <= *hi);
+  if (p->color == RBTREE_RED) {
+    assert(p->left->color == RBTREE_BLACK && p->right->color == RBTREE_BLACK);
+  }
+  assert(p->size == p->left->size + p->right->size + 1);
+  const int lh = check_subtree(t, p->left, p, lo, &p->key);
+  const int rh = check_subtree(t, p->right, p, &p->key, hi);
+  assert(lh == rh);
+  return lh + (p->color == RBTREE_BLACK);
+}
+
+static void check_tree(const rbtree *t) {
+  assert(t->root->color == RBTREE_BLACK);
+  check_subtree(t, t->root, t->nil, NULL, NULL);
+  assert(t->nil->color == RBTREE_BLACK && t->nil->size == 0);
+}
+
+static void check_keys(const rbtree *t, const key_t *expected, const size_t n) {
+  assert(rbtree_size(t) == n);
+  key_t *arr = calloc(n + 1, sizeof(key_t));
+  assert(rbtree_to_array(t, arr, n) == n);
+  for (int i = 0; i < n; i++) {
+    assert(arr[i] == expected[i]);
+  }
+  free(arr);
+}
+
+static rbtree *random_tree(const size_t n, const int range, key_t *keys) {
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++) {
+    keys[i] = rand() % range;
+    rbtree_insert(t, keys[i]);
+  }
+  qsort(keys, n, sizeof(key_t), comp);
+  return t;
+}
+
+// splitting at any key and joining the halves back should keep a valid tree
+void test_split_join(const size_t n, const unsigned int seed) {
+  srand(seed);
+  key_t *keys = calloc(n + 1, sizeof(key_t));
+  rbtree *t = random_tree(n, (int)n + 1, keys);
+
+  for (int i = 0; i < 20; i++) {
+    const key_t key = rand() % ((int)n + 3) - 1;
+    const int inclusive = i % 2;
+    node_t *lo, *hi;
+    rbtree_split_subtree(t, t->root, key, inclusive, &lo, &hi);
+
+    rbtree half = *t;
+    half.root = lo;
+    check_tree(&half);
+    size_t expected = 0;
+    while (expected < n && (inclusive ? keys[expected] <= key : keys[expected] < key)) {
+      expected++;
+    }
+    check_keys(&half, keys, expected);
+    half.root = hi;
+    check_tree(&half);
+    check_keys(&half, keys + expected, n - expected);
+
+    t->root = rbtree_join2_subtrees(t, lo, hi);
+    check_tree(t);
+    check_keys(t, keys, n);
+  }
+
+  // join through an explicit middle node: cut out the copies of one key,
+  // then use their root as the middle of the join
+  if (n > 0) {
+    const key_t key = rbtree_select(t, n / 2)->key;
+    node_t *lo, *hi, *rest, *equal;
+    rbtree_split_subtree(t, t->root, key, 0, &lo, &rest);
+    rbtree_split_subtree(t, rest, key, 1, &equal, &hi);
+    assert(equal != t->nil && equal->key == key);
+    node_t *left = equal->left, *right = equal->right;
+    lo = rbtree_join2_subtrees(t, lo, left);
+    hi = rbtree_join2_subtrees(t, right, hi);
+    t->root = rbtree_join_subtrees(t, lo, equal, hi);
+    check_tree(t);
+    check_keys(t, keys, n);
+  }
+
+  free(keys);
+  delete_rbtree(t);
+}
+
+typedef enum { OP_UNION, OP_INTERSECTION, OP_DIFFERENCE } set_op;
+
+static bool contains(const key_t *keys, const size_t n, const key_t key) {
+  return bsearch(&key, keys, n, sizeof(key_t), comp) != NULL;
+}
+
+// each set operation should match the result computed from sorted arrays
+void test_set_op(rbtree_pool *pool, const set_op op, const size_t n1, const size_t n2,
+                 const int range, const unsigned int seed) {
+  srand(seed);
+  key_t *k1 = calloc(n1 + 1, sizeof(key_t));
+  key_t *k2 = calloc(n2 + 1, sizeof(key_t));
+  key_t *expected = calloc(n1 + n2 + 1, sizeof(key_t));
+  rbtree *t1 = random_tree(n1, range, k1);
+  rbtree *t2 = random_tree(n2, range, k2);
+
+  size_t m = 0;
+  if (op == OP_UNION) {
+    for (int i = 0; i < n1; i++) {
+      expected[m++] = k1[i];
+    }
+    for (int i = 0; i < n2; i++) {
+      expected[m++] = k2[i];
+    }
+    qsort(expected, m, sizeof(key_t), comp);
+    rbtree_union(pool, t1, t2);
+  } else {
+    for (int i = 0; i < n1; i++) {
+      if (contains(k2, n2, k1[i]) == (op == OP_INTERSECTION)) {
+        expected[m++] = k1[i];
+      }
+    }
+    if (op == OP_INTERSECTION) {
+      rbtree_intersection(pool, t1, t2);
+    } else {
+      rbtree_difference(pool, t1, t2);
+    }
+  }
+
+  check_tree(t1);
+  check_keys(t1, expected, m);
+  check_tree(t2);
+  check_keys(t2, k2, n2);
+
+  // the tree keeps working, and dropped nodes get reused
+  for (int i = 0; i < 1000; i++) {
+    rbtree_insert(t1, rand() % range);
+  }
+  check_tree(t1);
+  assert(rbtree_size(t1) == m + 1000);
+
+  free(expected);
+  free(k2);
+  free(k1);
+  delete_rbtree(t2);
+  delete_rbtree(t1);
+}
+
+void test_set_ops(rbtree_pool *pool) {
+  const size_t sizes[][2] = {{0, 0}, {0, 100}, {100, 0}, {1, 1}, {1000, 10}, {10, 1000},
+                             {5000, 5000}, {50000, 30000}, {100000, 100}};
+  for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    for (int op = OP_UNION; op <= OP_DIFFERENCE; op++) {
+      test_set_op(pool, (set_op)op, sizes[i][0], sizes[i][1], 100000, i * 3 + op);
+      test_set_op(pool, (set_op)op, sizes[i][0], sizes[i][1], 1000, i * 3 + op);
+    }
+  }
+}
+
+// a tree combined with itself
+void test_set_op_self(rbtree_pool *pool) {
+  key_t *keys = calloc(20000, sizeof(key_t));
+  key_t *twice = calloc(40000, sizeof(key_t));
+  rbtree *t = random_tree(20000, 5000, keys);
+
+  rbtree_intersection(pool, t, t);
+  check_tree(t);
+  check_keys(t, keys, 20000);
+
+  rbtree_union(pool, t, t);
+  for (int i = 0; i < 40000; i++) {
+    twice[i] = keys[i / 2];
+  }
+  check_tree(t);
+  check_keys(t, twice, 40000);
+
+  rbtree_difference(pool, t, t);
+  check_tree(t);
+  assert(rbtree_size(t) == 0);
+  rbtree_insert(t, 7);
+  assert(rbtree_size(t) == 1);
+
+  free(twice);
+  free(keys);
+  delete_rbtree(t);
+}
+
+void test_build_export(rbtree_pool *pool, const size_t n) {
+  key_t *arr = calloc(n + 1, sizeof(key_t));
+  key_t *out = calloc(n + 2, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = i / 3;
+  }
+
+  rbtree *t = rbtree_from_sorted_array_parallel(pool, arr, n);
+  check_tree(t);
+  check_keys(t, arr, n);
+
+  assert(rbtree_to_array_parallel(pool, t, out, n) == n);
+  for (int i = 0; i < n; i++) {
+    assert(out[i] == arr[i]);
+  }
+  // bounded export writes exactly the first k keys
+  const size_t k = n / 2 + 1;
+  out[k] = -1;
+  assert(rbtree_to_array_parallel(pool, t, out, k) == (k < n ? k : n));
+  if (k < n) {
+    assert(out[k] == -1);
+  }
+
+  rbtree_insert(t, -5);
+  node_t *p = rbtree_find(t, n / 6);
+  if (p != NULL) {
+    rbtree_erase(t, p);
+  }
+  check_tree(t);
+
+  free(out);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// counted trees merge equal keys into one node, also across a union
+void test_counted(rbtree_pool *pool) {
+  rbtree *a = new_rbtree_counted();
+  rbtree *b = new_rbtree();
+  key_t *expected = calloc(30000, sizeof(key_t));
+  key_t *out = calloc(30000, sizeof(key_t));
+  for (int i = 0; i < 20000; i++) {
+    rbtree_insert(a, i % 100);
+    expected[i] = i % 100;
+  }
+  for (int i = 0; i < 10000; i++) {
+    rbtree_insert(b, i % 150);
+    expected[20000 + i] = i % 150;
+  }
+  qsort(expected, 30000, sizeof(key_t), comp);
+
+  rbtree_union(pool, a, b);
+  assert(rbtree_count(a, rbtree_find(a, 5)) == 200 + 67);
+  assert(rbtree_to_array_parallel(pool, a, out, 30000) == 30000);
+  for (int i = 0; i < 30000; i++) {
+    assert(out[i] == expected[i]);
+  }
+
+  // keep the keys below 120, then drop the even ones
+  rbtree *c = new_rbtree();
+  for (int i = 0; i < 120; i++) {
+    rbtree_insert(c, i);
+  }
+  rbtree_intersection(pool, a, c);
+  size_t m = 0;
+  for (int i = 0; i < 30000; i++) {
+    m += expected[i] < 120;
+  }
+  assert(rbtree_size(a) == m);
+  delete_rbtree(c);
+  c = new_rbtree();
+  for (int i = 0; i < 150; i += 2) {
+    rbtree_insert(c, i);
+  }
+  rbtree_difference(pool, a, c);
+  m = 0;
+  for (int i = 0; i < 30000; i++) {
+    if (expected[i] < 120 && expected[i] % 2 == 1) {
+      expected[m++] = expected[i];
+    }
+  }
+  assert(rbtree_to_array(a, out, 30000) == m);
+  for (int i = 0; i < m; i++) {
+    assert(out[i] == expected[i]);
+  }
+  assert(rbtree_count(a, rbtree_find(a, 5)) == 267);
+
+  delete_rbtree(c);
+  free(out);
+  free(expected);
+  delete_rbtree(b);
+  delete_rbtree(a);
+}
+
+int main(void) {
+  test_split_join(0, 1);
+  test_split_join(1, 2);
+  test_split_join(100, 3);
+  test_split_join(5000, 4);
+
+  rbtree_pool *pools[] = {NULL, new_rbtree_pool(1), new_rbtree_pool(4)};
+  for (int i = 0; i < 3; i++) {
+    test_set_ops(pools[i]);
+    test_set_op_self(pools[i]);
+    test_counted(pools[i]);
+    const size_t sizes[] = {0, 1, 2, 3, 4096, 4097, 10000, 200000};
+    for (int j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+      test_build_export(pools[i], sizes[j]);
+    }
+    delete_rbtree_pool(pools[i]);
+  }
+  printf("Passed all tests!\n");
+}
@@ -0,0 +1,234 @@
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <rbtree_persistent.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// checks the red-black properties and subtree sizes, returns the black height
+static int check_subtree(const vnode_t *n, const key_t lo, const key_t hi) {
+  if (n == NULL) {
+    return 1;
+  }
+  assert(lo <= n->key && n->key <= hi);
+  assert(atomic_load(&n->refs) >= 1);
+  if (n->color == RBTREE_RED) {
+    assert(n->left == NULL || n->left->color == RBTREE_BLACK);
+    assert(n->right == NULL || n->right->color == RBTREE_BLACK);
+  }
+  const int hl = check_subtree(n->left, lo, n->key);
+  const int hr = check_subtree(n->right, n->key, hi);
+  assert(hl == hr);
+  assert(n->size == (n->left ? n->left->size : 0) + (n->right ? n->right->size : 0) + 1);
+  return hl + (n->color == RBTREE_BLACK);
+}
+
+static void check_version(const rbtree_version *v, const rbtree *ref) {
+  assert(v->root == NULL || v->root->color == RBTREE_BLACK);
+  check_subtree(v->root, INT_MIN, INT_MAX);
+
+  const size_t n = rbtree_size(ref);
+  assert(rbtree_version_size(v) == n);
+  key_t *a = calloc(n + 1, sizeof(key_t));
+  key_t *b = calloc(n + 1, sizeof(key_t));
+  assert(rbtree_version_to_array(v, a, n + 1) == n);
+  assert(rbtree_version_to_array(v, a, n / 2) == n / 2);
+  assert(rbtree_version_to_array(v, a, n) == n);
+  rbtree_to_array(ref, b, n);
+  for (int i = 0; i < n; i++) {
+    assert(a[i] == b[i]);
+  }
+
+  for (key_t key = -5; key < 305; key += 7) {
+    assert(rbtree_version_contains(v, key) == (rbtree_find(ref, key) != NULL));
+    key_t got;
+    node_t *p = rbtree_lower_bound(ref, key);
+    assert(rbtree_version_lower_bound(v, key, &got) == (p != NULL));
+    assert(p == NULL || got == p->key);
+  }
+  const size_t got = rbtree_version_range(v, 50, 150, a, n);
+  assert(got == rbtree_range(ref, 50, 150, b, n));
+  for (int i = 0; i < got; i++) {
+    assert(a[i] == b[i]);
+  }
+  assert(rbtree_version_range(v, 150, 50, a, n) == 0);
+
+  free(b);
+  free(a);
+}
+
+static rbtree *copy_tree(const rbtree *t) {
+  const size_t n = rbtree_size(t);
+  key_t *a = calloc(n + 1, sizeof(key_t));
+  rbtree_to_array(t, a, n);
+  rbtree *c = rbtree_from_sorted_array(a, n);
+  free(a);
+  return c;
+}
+
+// every version keeps its own contents while later versions are built from it
+void test_versions(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree_version **versions = calloc(n + 1, sizeof(rbtree_version *));
+  rbtree **refs = calloc(n + 1, sizeof(rbtree *));
+  rbtree *ref = new_rbtree();
+
+  versions[0] = new_rbtree_version();
+  refs[0] = copy_tree(ref);
+  for (int i = 1; i <= n; i++) {
+    // usually extend the latest version, sometimes branch off an older one
+    const int from = (rand() % 8 == 0) ? rand() % i : i - 1;
+    rbtree_version *v = versions[from];
+    delete_rbtree(ref);
+    ref = copy_tree(refs[from]);
+
+    const key_t key = rand() % 300;
+    if (rand() % 3 == 0) {
+      node_t *p = rbtree_find(ref, key);
+      versions[i] = rbtree_version_erase(v, key);
+      if (p != NULL) {
+        rbtree_erase(ref, p);
+      } else {
+        assert(versions[i] == v);  // nothing to erase: the same version comes back
+      }
+    } else {
+      versions[i] = rbtree_version_insert(v, key);
+      rbtree_insert(ref, key);
+    }
+    refs[i] = copy_tree(ref);
+    check_version(versions[i], refs[i]);
+  }
+
+  // older versions are untouched
+  for (int i = 0; i <= n; i++) {
+    check_version(versions[i], refs[i]);
+  }
+
+  // releasing in any order keeps the others readable
+  for (int i = 0; i <= n; i += 2) {
+    rbtree_version_release(versions[i]);
+  }
+  for (int i = 1; i <= n; i += 2) {
+    check_version(versions[i], refs[i]);
+    rbtree_version_release(versions[i]);
+  }
+
+  for (int i = 0; i <= n; i++) {
+    delete_rbtree(refs[i]);
+  }
+  delete_rbtree(ref);
+  free(refs);
+  free(versions);
+}
+
+// a long chain of edits on one version, freeing each older version right away
+void test_chain(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree_version *v = new_rbtree_version();
+  rbtree *ref = new_rbtree();
+
+  for (int i = 0; i < n; i++) {
+    const key_t key = rand() % 300;
+    rbtree_version *next;
+    if (rand() % 2 == 0) {
+      next = rbtree_version_insert(v, key);
+      rbtree_insert(ref, key);
+    } else {
+      next = rbtree_version_erase(v, key);
+      node_t *p = rbtree_find(ref, key);
+      if (p != NULL) {
+        rbtree_erase(ref, p);
+      }
+    }
+    rbtree_version_release(v);
+    v = next;
+  }
+  check_version(v, ref);
+
+  // a snapshot shares the whole tree
+  rbtree_version *s = rbtree_version_retain(v);
+  assert(s == v);
+  rbtree_version *w = rbtree_version_insert(v, 1000);
+  assert(w->root != v->root);
+  rbtree_version_release(v);
+  check_version(s, ref);
+  assert(!rbtree_version_contains(s, 1000) && rbtree_version_contains(w, 1000));
+
+  // untouched subtrees are shared, not copied
+  if (s->root != NULL && s->root->left != NULL) {
+    assert(w->root->left == s->root->left || w->root->right == s->root->right);
+  }
+  rbtree_version_release(s);
+  rbtree_version_release(w);
+  delete_rbtree(ref);
+}
+
+typedef struct {
+  rbtree_persistent *p;
+  size_t n;
+  atomic_int done;
+} shared_t;
+
+static void *writer(void *arg) {
+  shared_t *s = arg;
+  for (int i = 0; i < s->n; i++) {
+    rbtree_persistent_insert(s->p, i);
+    if (i % 3 == 0) {
+      assert(rbtree_persistent_erase(s->p, i / 3) == 1);
+    }
+  }
+  atomic_store(&s->done, 1);
+  return NULL;
+}
+
+// the writer inserts 0, 1, 2, ... and erases from the smallest key, so every snapshot holds
+// one run of consecutive keys; readers check that without taking any lock
+static void *reader(void *arg) {
+  shared_t *s = arg;
+  key_t *a = calloc(s->n + 1, sizeof(key_t));
+  while (!atomic_load(&s->done)) {
+    rbtree_version *v = rbtree_persistent_snapshot(s->p);
+    const size_t m = rbtree_version_size(v);
+    assert(rbtree_version_to_array(v, a, m) == m);
+    for (int i = 1; i < m; i++) {
+      assert(a[i] == a[0] + i);
+    }
+    if (m > 0) {
+      assert(rbtree_version_contains(v, a[m - 1]) && !rbtree_version_contains(v, a[0] - 1));
+    }
+    rbtree_version_release(v);
+  }
+  free(a);
+  return NULL;
+}
+
+void test_concurrent(const size_t n, const int readers) {
+  shared_t s = {.p = new_rbtree_persistent(), .n = n};
+  pthread_t w, r[8];
+  atomic_init(&s.done, 0);
+
+  for (int i = 0; i < readers; i++) {
+    pthread_create(&r[i], NULL, reader, &s);
+  }
+  pthread_create(&w, NULL, writer, &s);
+  pthread_join(w, NULL);
+  for (int i = 0; i < readers; i++) {
+    pthread_join(r[i], NULL);
+  }
+
+  rbtree_version *v = rbtree_persistent_snapshot(s.p);
+  assert(rbtree_version_size(v) == n - (n + 2) / 3);
+  assert(rbtree_persistent_erase(s.p, -1) == 0);
+  delete_rbtree_persistent(s.p);
+  // the snapshot outlives the tree it came from
+  assert(rbtree_version_contains(v, (key_t)n - 1));
+  rbtree_version_release(v);
+}
+
+int main(void) {
+  test_versions(1, 1);
+  test_versions(500, 2);
+  test_chain(20000, 3);
+  test_concurrent(20000, 3);
+  printf("Passed all tests!\n");
+}
@@ -8,7 +8,9 @@
 void test_init(void) {
   rbtree *t = new_rbtree();
   assert(t != NULL);
-#ifdef SENTINEL
+#if defined(RBTREE_BTREE)
+  assert(t->root == NULL && rbtree_size(t) == 0);
+#elif defined(SENTINEL)
   assert(t->nil != NULL);
   assert(t->root == t->nil);
 #else
@@ -22,10 +24,16 @@ void test_insert_single(const key_t key) {
   rbtree *t = new_rbtree();
   node_t *p = rbtree_insert(t, key);
   assert(p != NULL);
-  assert(t->root == p);
   assert(p->key == key);
+#if defined(RBTREE_BTREE)
+  assert(t->height == 0 && rbtree_min(t) == p && rbtree_max(t) == p);
+#else
+  assert(t->root == p);
+#endif
   // assert(p->color == RBTREE_BLACK);  // color of root node should be black
-#ifdef SENTINEL
+#if defined(RBTREE_BTREE)
+  assert(rbtree_next(t, p) == NULL && rbtree_prev(t, p) == NULL);
+#elif defined(SENTINEL)
   assert(p->left == t->nil);
   assert(p->right == t->nil);
   assert(p->parent == t->nil);
@@ -58,11 +66,15 @@ void test_erase_root(const key_t key) {
   rbtree *t = new_rbtree();
   node_t *p = rbtree_insert(t, key);
   assert(p != NULL);
+#ifndef RBTREE_BTREE
   assert(t->root == p);
+#endif
   assert(p->key == key);
 
   rbtree_erase(t, p);
-#ifdef SENTINEL
+#if defined(RBTREE_BTREE)
+  assert(t->root == NULL && rbtree_min(t) == NULL);
+#elif defined(SENTINEL)
   assert(t->root == t->nil);
 #else
   assert(t->root == NULL);
@@ -99,7 +111,7 @@ void test_minmax(key_t *arr, const size_t n) {
 
   insert_arr(t, arr, n);
   assert(t->root != NULL);
-#ifdef SENTINEL
+#if defined(SENTINEL) && !defined(RBTREE_BTREE)
   assert(t->root != t->nil);
 #endif
 
@@ -118,6 +130,9 @@ void test_minmax(key_t *arr, const size_t n) {
   assert(p->key == arr[1]);
 
   if (n >= 2) {
+#ifdef RBTREE_BTREE
+    q = rbtree_max(t);  // erasing p moved the keys of its leaf
+#endif
     rbtree_erase(t, q);
     q = rbtree_max(t);
     assert(q != NULL);
@@ -175,6 +190,83 @@ void test_multi_instance() {
   delete_rbtree(t1);
 }
 
+#ifdef RBTREE_BTREE
+
+// The B-tree engine gets the same three checks on its own shape
+// Search tree constraint: keys are sorted within every node, bounded by the
+// separators above them, and the leaf list holds them all in order
+// Color constraint: every node except the root is at least half full
+// Size constraint: every count is the number of keys under that child
+
+enum { CHECK_ORDER = 1, CHECK_FILL = 2, CHECK_COUNT = 4 };
+
+static size_t btree_traverse(const void *x, const int h, const bool root, const key_t *lo,
+                             const key_t *hi, const int check) {
+  if (h == 0) {
+    const rbtree_bleaf *l = x;
+    if (check & CHECK_FILL) {
+      assert(l->n >= (root ? 1 : RBTREE_BTREE_LEAF_KEYS / 2) && l->n <= RBTREE_BTREE_LEAF_KEYS);
+    }
+    for (int i = 0; (check & CHECK_ORDER) && i < l->n; i++) {
+      assert(i == 0 || l->slots[i - 1].key <= l->slots[i].key);
+      assert((lo == NULL || *lo <= l->slots[i].key) && (hi == NULL || l->slots[i].key <= *hi));
+    }
+    return l->n;
+  }
+
+  const rbtree_bnode *b = x;
+  if (check & CHECK_FILL) {
+    assert(b->n >= (root ? 2 : RBTREE_BTREE_FANOUT / 2) && b->n <= RBTREE_BTREE_FANOUT);
+  }
+  size_t total = 0;
+  for (int i = 0; i < b->n; i++) {
+    const key_t *clo = (i > 0) ? &b->keys[i - 1] : lo;
+    const key_t *chi = (i < b->n - 1) ? &b->keys[i] : hi;
+    if ((check & CHECK_ORDER) && clo != NULL && chi != NULL) {
+      assert(*clo <= *chi);
+    }
+    const size_t size = btree_traverse(b->child[i], h - 1, false, clo, chi, check);
+    if (check & CHECK_COUNT) {
+      assert(b->count[i] == size);
+    }
+    total += size;
+  }
+  return total;
+}
+
+void test_search_constraint(const rbtree *t) {
+  assert(t != NULL);
+  if (t->root == NULL) {
+    assert(t->first == NULL && t->last == NULL);
+    return;
+  }
+  btree_traverse(t->root, t->height, true, NULL, NULL, CHECK_ORDER);
+
+  size_t n = 0;
+  for (const rbtree_bleaf *l = t->first; l != NULL; l = l->next) {
+    assert(l->prev == NULL ? l == t->first : l->prev->next == l);
+    assert(l->next != NULL || l == t->last);
+    assert(l->next == NULL || l->slots[l->n - 1].key <= l->next->slots[0].key);
+    n += l->n;
+  }
+  assert(n == rbtree_size(t));
+}
+
+void test_color_constraint(const rbtree *t) {
+  assert(t != NULL);
+  if (t->root != NULL) {
+    btree_traverse(t->root, t->height, true, NULL, NULL, CHECK_FILL);
+  }
+}
+
+void test_size_constraint(const rbtree *t) {
+  assert(t != NULL);
+  const size_t n = (t->root == NULL) ? 0 : btree_traverse(t->root, t->height, true, NULL, NULL, CHECK_COUNT);
+  assert(n == rbtree_size(t));
+}
+
+#else
+
 // Search tree constraint
 // The values of left subtree should be less than or equal to the current node
 // The values of right subtree should be greater than or equal to the current
@@ -265,6 +357,31 @@ void test_color_constraint(const rbtree *t) {
   assert(color_traverse(p, RBTREE_BLACK, 0, nil));
 }
 
+// Size constraint
+// The size of every node should be the number of nodes in its subtree
+
+static size_t size_traverse(const node_t *p, node_t *nil) {
+  if (p == nil) {
+    return 0;
+  }
+  const size_t l = size_traverse(p->left, nil);
+  const size_t r = size_traverse(p->right, nil);
+  assert(p->size == l + r + 1);
+  return p->size;
+}
+
+void test_size_constraint(const rbtree *t) {
+  assert(t != NULL);
+#ifdef SENTINEL
+  node_t *nil = t->nil;
+#else
+  node_t *nil = NULL;
+#endif
+  assert(size_traverse(t->root, nil) == rbtree_size(t));
+}
+
+#endif  // RBTREE_BTREE
+
 // rbtree should keep search tree and color constraints
 void test_rb_constraints(const key_t arr[], const size_t n) {
   rbtree *t = new_rbtree();
@@ -275,6 +392,7 @@ void test_rb_constraints(const key_t arr[], const size_t n) {
 
   test_color_constraint(t);
   test_search_constraint(t);
+  test_size_constraint(t);
 
   delete_rbtree(t);
 }
@@ -367,6 +485,697 @@ void test_find_erase_rand(const size_t n, const unsigned int seed) {
   delete_rbtree(t);
 }
 
+// nodes freed by erase should be recycled and a capacity hint should not
+// change the tree semantics
+void test_capacity_recycle(const size_t n) {
+  rbtree *t = new_rbtree_with_capacity(n);
+  assert(t != NULL);
+#if defined(SENTINEL) && !defined(RBTREE_BTREE)
+  assert(t->root == t->nil);
+#endif
+
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = (key_t)((i * 7919) % n);
+  }
+  insert_arr(t, arr, n);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  node_t *p = rbtree_find(t, arr[0]);
+  assert(p != NULL);
+  rbtree_erase(t, p);
+  node_t *q = rbtree_insert(t, arr[0]);
+#ifndef RBTREE_BTREE
+  assert(q == p);
+#endif
+  assert(q->key == arr[0]);
+
+  free(arr);
+  delete_rbtree(t);
+}
+
+// a tree built from a sorted array should keep the rbtree constraints and
+// hold exactly the given keys
+void test_from_sorted_array(const size_t n) {
+  key_t *arr = calloc(n + 1, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = (key_t)(i / 3);  // include duplicates
+  }
+
+  rbtree *t = rbtree_from_sorted_array(arr, n);
+  assert(t != NULL);
+  test_color_constraint(t);
+  test_search_constraint(t);
+  test_size_constraint(t);
+
+  key_t *res = calloc(n + 1, sizeof(key_t));
+  rbtree_to_array(t, res, n);
+  for (int i = 0; i < n; i++) {
+    assert(arr[i] == res[i]);
+  }
+
+  if (n > 0) {
+    assert(rbtree_min(t)->key == arr[0]);
+    assert(rbtree_max(t)->key == arr[n - 1]);
+    node_t *p = rbtree_insert(t, arr[n - 1] + 1);
+    assert(p != NULL);
+    test_color_constraint(t);
+    rbtree_erase(t, rbtree_find(t, arr[0]));
+    test_color_constraint(t);
+    test_search_constraint(t);
+  }
+
+  free(res);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// to_array should write at most n keys and return how many were written
+void test_to_array_bounded(void) {
+  const key_t entries[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12};
+  const size_t n = sizeof(entries) / sizeof(entries[0]);
+  key_t sorted[sizeof(entries) / sizeof(entries[0])];
+  rbtree *t = new_rbtree();
+
+  assert(rbtree_to_array(t, sorted, n) == 0);
+
+  insert_arr(t, entries, n);
+  for (int i = 0; i < n; i++) {
+    sorted[i] = entries[i];
+  }
+  qsort((void *)sorted, n, sizeof(key_t), comp);
+
+  key_t res[sizeof(entries) / sizeof(entries[0]) + 1];
+  res[4] = -1;
+  assert(rbtree_to_array(t, res, 4) == 4);
+  for (int i = 0; i < 4; i++) {
+    assert(res[i] == sorted[i]);
+  }
+  assert(res[4] == -1);
+  assert(rbtree_to_array(t, res, n + 1) == n);
+
+  // drain in pages of 3 keys through a cursor
+  rbtree_cursor cursor = {NULL, 0};
+  size_t total = 0, got;
+  while ((got = rbtree_to_array_batch(t, &cursor, res, 3)) > 0) {
+    assert(got <= 3);
+    for (int i = 0; i < got; i++) {
+      assert(res[i] == sorted[total + i]);
+    }
+    total += got;
+  }
+  assert(total == n);
+
+  delete_rbtree(t);
+}
+
+// select/rank should agree with the sorted key sequence
+void test_order_statistics(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % (n / 2 + 1);  // include duplicates
+  }
+  insert_arr(t, arr, n);
+  assert(rbtree_size(t) == n);
+  test_size_constraint(t);
+
+  // erase every third key
+  size_t m = 0;
+  for (int i = 0; i < n; i++) {
+    if (i % 3 == 0) {
+      rbtree_erase(t, rbtree_find(t, arr[i]));
+    } else {
+      arr[m++] = arr[i];
+    }
+  }
+  assert(rbtree_size(t) == m);
+  test_size_constraint(t);
+  test_color_constraint(t);
+
+  qsort((void *)arr, m, sizeof(key_t), comp);
+  for (size_t k = 0; k < m; k++) {
+    node_t *p = rbtree_select(t, k);
+    assert(p != NULL);
+    assert(p->key == arr[k]);
+    size_t lt = k;
+    while (lt > 0 && arr[lt - 1] == arr[k]) {
+      lt--;
+    }
+    assert(rbtree_rank(t, arr[k]) == lt);
+  }
+  assert(rbtree_select(t, m) == NULL);
+  assert(rbtree_rank(t, arr[m - 1] + 1) == m);
+
+  free(arr);
+  delete_rbtree(t);
+
+  t = rbtree_from_sorted_array(NULL, 0);
+  assert(rbtree_size(t) == 0);
+  assert(rbtree_select(t, 0) == NULL);
+  delete_rbtree(t);
+}
+
+static int sum_visit(node_t *p, void *arg) {
+  *(long *)arg += p->key;
+  return 0;
+}
+
+// next/prev should walk the keys in order and bound/range queries should
+// match a scan of the sorted keys
+void test_iterate_range(void) {
+  key_t arr[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
+  const size_t n = sizeof(arr) / sizeof(arr[0]);
+  rbtree *t = new_rbtree();
+  insert_arr(t, arr, n);
+  qsort((void *)arr, n, sizeof(key_t), comp);
+
+  int i = 0;
+  for (node_t *p = rbtree_min(t); p != NULL; p = rbtree_next(t, p)) {
+    assert(p->key == arr[i++]);
+  }
+  assert(i == n);
+  for (node_t *p = rbtree_max(t); p != NULL; p = rbtree_prev(t, p)) {
+    assert(p->key == arr[--i]);
+  }
+  assert(i == 0);
+
+  for (key_t key = 0; key <= 1000; key++) {
+    size_t lb = 0, ub = 0;
+    while (lb < n && arr[lb] < key) lb++;
+    while (ub < n && arr[ub] <= key) ub++;
+    node_t *p = rbtree_lower_bound(t, key);
+    assert(lb == n ? p == NULL : (p != NULL && p->key == arr[lb]));
+    p = rbtree_upper_bound(t, key);
+    assert(ub == n ? p == NULL : (p != NULL && p->key == arr[ub]));
+  }
+
+  key_t res[sizeof(arr) / sizeof(arr[0])];
+  assert(rbtree_range(t, 9, 34, res, n) == 7);
+  assert(res[0] == 10 && res[1] == 12 && res[6] == 34);
+  assert(rbtree_range(t, 9, 34, res, 3) == 3);
+  assert(rbtree_range(t, 35, 35, res, n) == 0);
+
+  long sum = 0;
+  assert(rbtree_range_foreach(t, 24, 25, sum_visit, &sum) == 3);
+  assert(sum == 24 + 24 + 25);
+
+  delete_rbtree(t);
+}
+
+// batched lookups should return what one find per key returns
+void test_find_batch(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % (2 * n);
+    if (i % 2 == 0) {
+      rbtree_insert(t, arr[i]);
+    }
+  }
+
+  node_t **res = calloc(n, sizeof(node_t *));
+  size_t found = rbtree_find_batch(t, arr, n, res);
+  size_t expected = 0;
+  for (int i = 0; i < n; i++) {
+    assert(res[i] == rbtree_find(t, arr[i]));
+    expected += (res[i] != NULL);
+  }
+  assert(found == expected);
+  assert(found >= (n + 1) / 2);
+  assert(rbtree_find_batch(t, arr, 0, res) == 0);
+
+  free(res);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// batched insert and erase should leave the same keys as one call per key
+void test_insert_erase_batch(const size_t n, const int range, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  rbtree *ref = new_rbtree();
+  key_t *arr = calloc(n + 1, sizeof(key_t));
+  key_t *res = calloc(2 * n + 1, sizeof(key_t));
+  key_t *expected = calloc(2 * n + 1, sizeof(key_t));
+
+  // two rounds so the second batch lands in a non-empty tree and reuses erased nodes
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < n; i++) {
+      arr[i] = rand() % range;
+      rbtree_insert(ref, arr[i]);
+    }
+    rbtree_insert_batch(t, arr, n);
+    test_search_constraint(t);
+    test_color_constraint(t);
+    test_size_constraint(t);
+
+    const size_t m = rbtree_size(ref);
+    assert(rbtree_size(t) == m);
+    rbtree_to_array(t, res, m);
+    rbtree_to_array(ref, expected, m);
+    for (int i = 0; i < m; i++) {
+      assert(res[i] == expected[i]);
+    }
+
+    // erase a mix of present, missing and repeated keys
+    size_t erased = 0;
+    for (int i = 0; i < n; i++) {
+      arr[i] = (i % 3 == 0) ? arr[i / 2] : rand() % (2 * range);
+      node_t *p = rbtree_find(ref, arr[i]);
+      if (p != NULL) {
+        rbtree_erase(ref, p);
+        erased++;
+      }
+    }
+    assert(rbtree_erase_batch(t, arr, n) == erased);
+    test_search_constraint(t);
+    test_color_constraint(t);
+    test_size_constraint(t);
+
+    const size_t left = rbtree_size(ref);
+    assert(rbtree_size(t) == left);
+    rbtree_to_array(t, res, left);
+    rbtree_to_array(ref, expected, left);
+    for (int i = 0; i < left; i++) {
+      assert(res[i] == expected[i]);
+    }
+  }
+  rbtree_insert_batch(t, arr, 0);
+  assert(rbtree_erase_batch(t, arr, 0) == 0);
+
+  free(expected);
+  free(res);
+  free(arr);
+  delete_rbtree(ref);
+  delete_rbtree(t);
+}
+
+// hinted inserts and finger searches should agree with the root-based versions
+void test_insert_hint_find_from(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  rbtree *ref = new_rbtree();
+  key_t *res = calloc(2 * n + 2, sizeof(key_t));
+  key_t *expected = calloc(2 * n + 2, sizeof(key_t));
+
+  // near-sorted appends with the previous node as the hint
+  node_t *hint = NULL;
+  for (int i = 0; i < n; i++) {
+    const key_t key = i * 2 + (rand() % 5 == 0 ? -(rand() % 8) : 0);
+    hint = rbtree_insert_hint(t, hint, key);
+    assert(hint->key == key);
+    rbtree_insert(ref, key);
+  }
+  // random keys with random (possibly far away) hints
+  for (int i = 0; i < n; i++) {
+    const key_t key = rand() % (2 * n + 10) - 5;
+    rbtree_insert_hint(t, rbtree_select(t, rand() % rbtree_size(t)), key);
+    rbtree_insert(ref, key);
+  }
+  rbtree_insert_hint(t, rbtree_min(t), -100);
+  rbtree_insert(ref, -100);
+  rbtree_insert_hint(t, rbtree_max(t), 1 << 30);
+  rbtree_insert(ref, 1 << 30);
+  test_search_constraint(t);
+  test_color_constraint(t);
+  test_size_constraint(t);
+
+  const size_t m = rbtree_size(ref);
+  assert(rbtree_size(t) == m);
+  rbtree_to_array(t, res, m);
+  rbtree_to_array(ref, expected, m);
+  for (int i = 0; i < m; i++) {
+    assert(res[i] == expected[i]);
+  }
+
+  for (int i = 0; i < 3 * n; i++) {
+    const key_t key = rand() % (2 * n + 20) - 10;
+    node_t *finger = rbtree_select(t, rand() % m);
+    node_t *p = rbtree_find_from(t, finger, key);
+    assert((p == NULL) == (rbtree_find(t, key) == NULL));
+    assert(p == NULL || p->key == key);
+  }
+  assert(rbtree_find_from(t, NULL, -100)->key == -100);
+  assert(rbtree_find_from(t, rbtree_min(t), 1 << 30)->key == 1 << 30);
+
+  free(expected);
+  free(res);
+  delete_rbtree(ref);
+  delete_rbtree(t);
+}
+
+// erasing a key range should leave exactly the keys outside [lo, hi]
+void test_erase_range(const size_t n, const int range, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *expected = calloc(n + 1, sizeof(key_t));
+  key_t *res = calloc(n + 1, sizeof(key_t));
+  size_t m = 0;
+
+  for (int i = 0; i < n; i++) {
+    expected[m++] = rand() % range;
+    rbtree_insert(t, expected[m - 1]);
+  }
+  assert(rbtree_erase_range(t, 10, 9) == 0);
+  assert(rbtree_erase_range(t, range, 2 * range) == 0);
+  assert(rbtree_size(t) == m);
+
+  for (int q = 0; q < 40 && m > 0; q++) {
+    const key_t lo = rand() % (range + 20) - 10;
+    const key_t hi = lo + rand() % (q % 2 ? 5 : range / 4 + 1);
+    size_t kept = 0;
+    for (int i = 0; i < m; i++) {
+      if (expected[i] < lo || hi < expected[i]) {
+        expected[kept++] = expected[i];
+      }
+    }
+    assert(rbtree_erase_range(t, lo, hi) == m - kept);
+    m = kept;
+    test_search_constraint(t);
+    test_color_constraint(t);
+    test_size_constraint(t);
+
+    assert(rbtree_size(t) == m);
+    qsort(expected, m, sizeof(key_t), comp);
+    rbtree_to_array(t, res, m);
+    for (int i = 0; i < m; i++) {
+      assert(res[i] == expected[i]);
+    }
+  }
+
+  // erased nodes go back to the tree and are handed out again by insert and insert_batch
+  for (int i = 0; i < n / 4; i++) {
+    rbtree_insert(t, rand() % range);
+  }
+  for (int i = 0; i < n / 4; i++) {
+    res[i] = rand() % range;
+  }
+  rbtree_insert_batch(t, res, n / 4);
+  test_search_constraint(t);
+  test_color_constraint(t);
+  test_size_constraint(t);
+  assert(rbtree_size(t) == m + n / 4 * 2);
+  assert(rbtree_erase_range(t, -1, range) == m + n / 4 * 2);
+  assert(rbtree_size(t) == 0);
+  rbtree_insert(t, 1);
+  test_size_constraint(t);
+  assert(rbtree_size(t) == 1);
+
+  free(res);
+  free(expected);
+  delete_rbtree(t);
+}
+
+#ifndef RBTREE_BTREE
+// compaction keeps the keys and the shape and leaves the nodes in one in-order block
+void test_compact(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *before = calloc(n + 1, sizeof(key_t));
+  key_t *after = calloc(n + 1, sizeof(key_t));
+  rbtree_memory_t mem;
+
+  rbtree_compact(t);
+  rbtree_memory_usage(t, &mem);
+  assert(mem.nodes == 0 && mem.free_nodes == 0 && mem.slabs == 0 && mem.fragmentation == 0.0);
+
+  // churn so that nodes end up out of order and some slots are free
+  for (int i = 0; i < n; i++) {
+    rbtree_insert(t, rand() % (int)(n + 1));
+  }
+  for (int i = 0; i < n / 3; i++) {
+    node_t *p = rbtree_find(t, rand() % (int)(n + 1));
+    if (p != NULL) {
+      rbtree_erase(t, p);
+    }
+  }
+  rbtree_erase_range(t, (key_t)(n / 2), (key_t)(n / 2 + n / 10));
+  const size_t m = rbtree_size(t);
+  rbtree_memory_usage(t, &mem);
+  assert(mem.nodes == m && mem.free_nodes + mem.nodes >= n && mem.slabs > 0);
+  assert(mem.bytes >= sizeof(rbtree) + (mem.nodes + mem.free_nodes) * sizeof(node_t));
+  assert(m < 2 || mem.fragmentation > 0.0);
+
+  rbtree_to_array(t, before, m);
+  const key_t root_key = t->root->key;
+  rbtree_compact(t);
+  test_search_constraint(t);
+  test_color_constraint(t);
+  test_size_constraint(t);
+  assert(rbtree_size(t) == m && (m == 0 || t->root->key == root_key));
+  rbtree_to_array(t, after, m);
+  for (int i = 0; i < m; i++) {
+    assert(after[i] == before[i]);
+  }
+
+  rbtree_memory_usage(t, &mem);
+  assert(mem.nodes == m && mem.free_nodes == 0 && mem.slabs == (m > 0));
+  assert(mem.fragmentation == 0.0);
+  if (m > 0) {
+    node_t *first = rbtree_min(t);
+    size_t i = 0;
+    for (node_t *p = first; p != NULL; p = rbtree_next(t, p), i++) {
+      assert(p == first + i);
+    }
+    assert(i == m);
+  }
+
+  // the compacted tree keeps working
+  for (int i = 0; i < n / 2; i++) {
+    rbtree_insert(t, rand() % (int)(n + 1));
+    if (i % 3 == 0) {
+      rbtree_erase(t, rbtree_max(t));
+    }
+  }
+  test_color_constraint(t);
+  test_size_constraint(t);
+
+  free(after);
+  free(before);
+  delete_rbtree(t);
+}
+
+// a counted tree keeps one node per key, ordered strictly, and each size
+// counts the multiplicities below it; returns the number of nodes
+static size_t counted_traverse(const rbtree *t, const node_t *p, const key_t *lo, const key_t *hi) {
+  if (p == t->nil) {
+    return 0;
+  }
+  assert(lo == NULL || *lo < p->key);
+  assert(hi == NULL || p->key < *hi);
+  assert(p->size > p->left->size + p->right->size);
+  assert(rbtree_count(t, p) == p->size - p->left->size - p->right->size);
+  return counted_traverse(t, p->left, lo, &p->key) + counted_traverse(t, p->right, &p->key, hi) + 1;
+}
+
+// compares a counted tree against the same keys in a plain multiset
+static void check_counted(const rbtree *t, const rbtree *ref, const key_t range) {
+  const size_t n = rbtree_size(ref);
+  key_t *got = calloc(n + 1, sizeof(key_t));
+  key_t *expected = calloc(n + 1, sizeof(key_t));
+
+  test_color_constraint(t);
+  assert(rbtree_size(t) == n);
+  size_t distinct = 0;
+  // rbtree_min of an empty tree is the nil sentinel, not NULL
+  for (node_t *p = (n > 0) ? rbtree_min(ref) : NULL; p != NULL; p = rbtree_next(ref, p)) {
+    node_t *q = rbtree_prev(ref, p);
+    distinct += (q == NULL || q->key != p->key);
+  }
+  assert(counted_traverse(t, t->root, NULL, NULL) == distinct);
+
+  assert(rbtree_to_array(t, got, n + 1) == n);
+  assert(rbtree_to_array(ref, expected, n) == n);
+  for (int i = 0; i < n; i++) {
+    assert(got[i] == expected[i]);
+  }
+  for (size_t k = 0; k < n; k++) {
+    assert(rbtree_select(t, k)->key == expected[k]);
+  }
+  assert(rbtree_select(t, n) == NULL);
+  for (key_t key = -1; key <= range; key++) {
+    const size_t c = rbtree_rank(ref, key + 1) - rbtree_rank(ref, key);
+    node_t *p = rbtree_find(t, key);
+    assert(rbtree_rank(t, key) == rbtree_rank(ref, key));
+    assert(c == 0 ? p == NULL : p != NULL && p->key == key && rbtree_count(t, p) == c);
+  }
+
+  // a bounded to_array cuts a node short, range expands the copies
+  if (n > 2) {
+    assert(rbtree_to_array(t, got, n / 2) == n / 2);
+    for (int i = 0; i < n / 2; i++) {
+      assert(got[i] == expected[i]);
+    }
+    assert(rbtree_range(t, 0, range, got, 3) == 3 && got[2] == expected[2]);
+    const size_t m = rbtree_range(t, range / 4, range / 2, got, n);
+    assert(m == rbtree_range(ref, range / 4, range / 2, expected, n));
+    for (int i = 0; i < m; i++) {
+      assert(got[i] == expected[i]);
+    }
+  }
+
+  free(expected);
+  free(got);
+}
+
+// a counted tree behaves like the expanded multiset with one node per key
+void test_counted(const size_t n, const key_t range, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree_counted();
+  rbtree *ref = new_rbtree();
+  key_t *arr = calloc(n + 1, sizeof(key_t));
+
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % range;
+    node_t *p = rbtree_insert(t, arr[i]);
+    assert(p->key == arr[i] && p == rbtree_find(t, arr[i]));
+    rbtree_insert(ref, arr[i]);
+  }
+  check_counted(t, ref, range);
+
+  // hints and batches add to the existing nodes as well
+  node_t *hint = NULL;
+  for (int i = 0; i < n / 2; i++) {
+    hint = rbtree_insert_hint(t, hint, arr[i]);
+    rbtree_insert(ref, arr[i]);
+  }
+  rbtree_insert_batch(t, arr + n / 2, n - n / 2);
+  insert_arr(ref, arr + n / 2, n - n / 2);
+  check_counted(t, ref, range);
+
+  // erase takes one copy at a time and keeps the node until the last one
+  for (int i = 0; i < n; i++) {
+    const key_t key = rand() % (range + 2) - 1;
+    node_t *p = rbtree_find(t, key);
+    node_t *q = rbtree_find(ref, key);
+    assert((p == NULL) == (q == NULL));
+    if (p == NULL) {
+      continue;
+    }
+    const size_t c = rbtree_count(t, p);
+    rbtree_erase(t, p);
+    rbtree_erase(ref, q);
+    assert(c == 1 ? rbtree_find(t, key) == NULL : rbtree_find(t, key) == p && rbtree_count(t, p) == c - 1);
+  }
+  check_counted(t, ref, range);
+
+  // a cursor splits a node's copies across pages, down to one key per page;
+  // one hot key holds more copies than the largest page
+  for (int i = 0; i < 200; i++) {
+    rbtree_insert(t, range / 3);
+    rbtree_insert(ref, range / 3);
+  }
+  const size_t size = rbtree_size(ref);
+  key_t *all = calloc(size + 1, sizeof(key_t));
+  assert(rbtree_to_array(t, all, size) == size);
+  const size_t pages[] = {1, 2, 3, 64};
+  for (int k = 0; k < sizeof(pages) / sizeof(pages[0]); k++) {
+    key_t out[64];
+    rbtree_cursor cursor = {NULL, 0};
+    size_t total = 0, got;
+    while ((got = rbtree_to_array_batch(t, &cursor, out, pages[k])) > 0) {
+      assert(got == pages[k] || total + got == size);
+      for (int i = 0; i < got; i++) {
+        assert(out[i] == all[total + i]);
+      }
+      total += got;
+    }
+    assert(total == size && cursor.node == t->nil);
+  }
+  free(all);
+
+  // split and join carry the multiplicities along
+  if (rbtree_size(t) > 0) {
+    const key_t key = rbtree_select(t, rbtree_size(t) / 2)->key;
+    node_t *lo, *hi;
+    rbtree_split_subtree(t, t->root, key, 1, &lo, &hi);
+    rbtree half = *t;
+    half.root = lo;
+    assert(rbtree_size(&half) == rbtree_rank(ref, key + 1));
+    counted_traverse(t, lo, NULL, NULL);
+    counted_traverse(t, hi, NULL, NULL);
+    t->root = rbtree_join2_subtrees(t, lo, hi);
+    check_counted(t, ref, range);
+  }
+
+  // a range erase drops whole nodes and reports every copy they held
+  assert(rbtree_erase_range(t, range / 4, range / 2) == rbtree_erase_range(ref, range / 4, range / 2));
+  check_counted(t, ref, range);
+
+  // compaction moves one node per key and keeps the multiplicities
+  rbtree_compact(t);
+  check_counted(t, ref, range);
+
+  assert(rbtree_erase_batch(t, arr, n) == rbtree_erase_batch(ref, arr, n));
+  check_counted(t, ref, range);
+
+  free(arr);
+  delete_rbtree(ref);
+  delete_rbtree(t);
+}
+
+#endif  // RBTREE_BTREE
+
+// counters are only collected in a STATS=1 build; otherwise rbtree_stats reports zeros
+void test_stats(const size_t n) {
+  rbtree *t = new_rbtree();
+  rbtree_stats_t st;
+
+  for (int i = 0; i < n; i++) {
+    rbtree_insert(t, i);
+  }
+  const int enabled = rbtree_stats(t, &st);
+#if defined(RBTREE_STATS) && !defined(RBTREE_BTREE)
+  assert(enabled);
+#else
+  assert(!enabled);
+#endif
+
+  size_t depths = 0;
+  for (int d = 0; d < RBTREE_STATS_DEPTH; d++) {
+    depths += st.insert_depth[d];
+  }
+  if (!enabled) {
+    assert(depths == 0 && st.rotations == 0 && st.node_allocs == 0);
+    delete_rbtree(t);
+    return;
+  }
+
+  // ascending inserts rotate at least once for every other node after the first few
+  assert(st.node_allocs == n && st.node_frees == 0);
+  assert(st.slab_allocs > 0);
+  assert(depths == n && st.insert_depth[0] == 1);
+  assert(st.rotations >= n / 2 - 2 && st.rotations <= n);
+  assert(st.insert_fixup_loops > 0 && st.recolors > 0);
+  assert(st.erase_fixup_loops == 0);
+
+  for (int i = 0; i < n; i++) {
+    rbtree_erase(t, rbtree_min(t));
+  }
+  rbtree_stats(t, &st);
+  assert(st.node_frees == n);
+  assert(st.erase_fixup_loops > 0);
+
+  rbtree_stats_reset(t);
+  rbtree_stats(t, &st);
+  assert(st.rotations == 0 && st.recolors == 0 && st.node_allocs == 0 && st.insert_depth[0] == 0);
+
+  // reused nodes and finger inserts next to the hint are counted too
+  node_t *hint = NULL;
+  for (int i = 0; i < 10; i++) {
+    hint = rbtree_insert_hint(t, hint, i);
+  }
+  rbtree_stats(t, &st);
+  assert(st.node_allocs == 10 && st.slab_allocs == 0);
+  assert(st.insert_depth[0] == 10);
+
+  delete_rbtree(t);
+}
+
 int main(void) {
   test_init();
   test_insert_single(1024);
@@ -379,5 +1188,33 @@ int main(void) {
   test_duplicate_values();
   test_multi_instance();
   test_find_erase_rand(10000, 17);
+  test_capacity_recycle(1000);
+  for (size_t n = 0; n <= 64; n++) {
+    test_from_sorted_array(n);
+  }
+  test_from_sorted_array(10000);
+  test_to_array_bounded();
+  test_order_statistics(3000, 7);
+  test_iterate_range();
+  test_find_batch(1000, 19);
+  test_find_batch(5, 23);
+  test_insert_erase_batch(3000, 1000, 29);
+  test_insert_erase_batch(3000, 1000000, 31);
+  test_insert_erase_batch(1, 10, 37);
+  test_insert_hint_find_from(3000, 41);
+  test_insert_hint_find_from(2, 43);
+  test_erase_range(3000, 1000, 67);
+  test_erase_range(3000, 30, 71);
+  test_erase_range(1, 1, 73);
+#ifndef RBTREE_BTREE
+  test_compact(3000, 79);
+  test_compact(1, 83);
+#endif
+  test_stats(1000);
+#ifndef RBTREE_BTREE
+  test_counted(3000, 50, 47);
+  test_counted(3000, 3000, 53);
+  test_counted(1, 1, 59);
+#endif
   printf("Passed all tests!\n");
 }
\ No newline at end of file
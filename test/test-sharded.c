@@ -0,0 +1,117 @@
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <rbtree_sharded.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// a sharded tree should answer every ordered query like a single rbtree
+void test_sharded_matches_rbtree(const size_t shards, const rbtree_shard_mode mode,
+                                 const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree_sharded *s = new_rbtree_sharded(shards, mode);
+  rbtree *t = new_rbtree();
+  key_t k;
+  assert(!rbtree_sharded_min(s, &k));
+
+  for (int i = 0; i < n; i++) {
+    key_t key = rand() % 2000 - 1000;
+    if (i % 7 == 0) {
+      key = (i % 2) ? INT_MAX - i : INT_MIN + i;
+    }
+    rbtree_sharded_insert(s, key);
+    rbtree_insert(t, key);
+  }
+  for (int i = 0; i < n / 4; i++) {
+    key_t key = rand() % 2000 - 1000;
+    node_t *p = rbtree_find(t, key);
+    assert(rbtree_sharded_erase(s, key) == (p != NULL));
+    if (p != NULL) {
+      rbtree_erase(t, p);
+    }
+    assert(rbtree_sharded_contains(s, key) == (rbtree_find(t, key) != NULL));
+  }
+
+  const size_t m = rbtree_size(t);
+  assert(rbtree_sharded_size(s) == m);
+  assert(rbtree_sharded_min(s, &k) && k == rbtree_min(t)->key);
+  assert(rbtree_sharded_max(s, &k) && k == rbtree_max(t)->key);
+
+  key_t *a = calloc(m, sizeof(key_t));
+  key_t *b = calloc(m, sizeof(key_t));
+  assert(rbtree_sharded_to_array(s, a, m) == m);
+  rbtree_to_array(t, b, m);
+  for (int i = 0; i < m; i++) {
+    assert(a[i] == b[i]);
+  }
+
+  const size_t got = rbtree_sharded_range(s, -100, 250, a, m);
+  assert(got == rbtree_range(t, -100, 250, b, m));
+  for (int i = 0; i < got; i++) {
+    assert(a[i] == b[i]);
+  }
+  assert(rbtree_sharded_range(s, -100, 250, a, 3) == (got < 3 ? got : 3));
+  assert(rbtree_sharded_range(s, 10, -10, a, m) == 0);
+
+  free(b);
+  free(a);
+  delete_rbtree(t);
+  delete_rbtree_sharded(s);
+}
+
+// keys spaced by the shard count (aligned ids, fixed-step timestamps) should still spread over every shard
+void test_sharded_stride(const size_t shards, const key_t stride) {
+  rbtree_sharded *s = new_rbtree_sharded(shards, RBTREE_SHARD_BY_HASH);
+  const size_t n = 1000 * shards;
+  for (size_t i = 0; i < n; i++) {
+    rbtree_sharded_insert(s, (key_t)i * stride);
+  }
+  assert(rbtree_sharded_size(s) == n);
+  for (size_t i = 0; i < s->n; i++) {
+    assert(rbtree_size(s->shards[i].tree) > n / shards / 4);
+  }
+  delete_rbtree_sharded(s);
+}
+
+static rbtree_sharded *shared;
+
+static void *insert_worker(void *arg) {
+  const key_t base = (key_t)(size_t)arg * 10000;
+  for (key_t k = 0; k < 10000; k++) {
+    rbtree_sharded_insert(shared, base + k);
+  }
+  return NULL;
+}
+
+// concurrent inserts into different shards should all land
+void test_sharded_threads(void) {
+  shared = new_rbtree_sharded(16, RBTREE_SHARD_BY_HASH);
+  pthread_t tid[8];
+  for (size_t i = 0; i < 8; i++) {
+    pthread_create(&tid[i], NULL, insert_worker, (void *)i);
+  }
+  for (int i = 0; i < 8; i++) {
+    pthread_join(tid[i], NULL);
+  }
+  assert(rbtree_sharded_size(shared) == 80000);
+  key_t *arr = calloc(80000, sizeof(key_t));
+  assert(rbtree_sharded_to_array(shared, arr, 80000) == 80000);
+  for (int i = 0; i < 80000; i++) {
+    assert(arr[i] == i);
+  }
+  free(arr);
+  delete_rbtree_sharded(shared);
+}
+
+int main(void) {
+  test_sharded_matches_rbtree(1, RBTREE_SHARD_BY_HASH, 3000, 1);
+  test_sharded_matches_rbtree(8, RBTREE_SHARD_BY_HASH, 3000, 2);
+  test_sharded_matches_rbtree(8, RBTREE_SHARD_BY_RANGE, 3000, 3);
+  test_sharded_matches_rbtree(3, RBTREE_SHARD_BY_RANGE, 3000, 4);
+  test_sharded_stride(8, 8);
+  test_sharded_stride(16, 16);
+  test_sharded_stride(16, 4096);
+  test_sharded_stride(3, 3);
+  test_sharded_threads();
+  printf("Passed all tests!\n");
+}
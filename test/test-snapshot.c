@@ -0,0 +1,81 @@
+#include <assert.h>
+#include <rbtree_snapshot.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// snapshot lookups should agree with the live tree it was frozen from
+void test_freeze(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++) {
+    rbtree_insert(t, rand() % (4 * n + 1));
+  }
+
+  rbtree_snapshot *s = rbtree_freeze(t);
+  assert(s != NULL);
+  assert(s->n == n);
+
+  for (key_t key = -1; key <= 4 * n + 2; key++) {
+    node_t *lb = rbtree_lower_bound(t, key);
+    const key_t *p = rbtree_snapshot_lower_bound(s, key);
+    if (lb == NULL) {
+      assert(p == NULL);
+    } else {
+      assert(p != NULL && *p == lb->key);
+    }
+
+    p = rbtree_snapshot_find(s, key);
+    if (rbtree_find(t, key) == NULL) {
+      assert(p == NULL);
+    } else {
+      assert(p != NULL && *p == key);
+    }
+  }
+
+  // writes go to the live tree and show up after a rebuild
+  rbtree_insert(t, 8 * n);
+  assert(rbtree_snapshot_find(s, 8 * n) == NULL);
+  assert(rbtree_snapshot_rebuild(s, t) == s);
+  assert(s->n == n + 1);
+  assert(rbtree_snapshot_find(s, 8 * n) != NULL);
+
+  delete_rbtree_snapshot(s);
+  delete_rbtree(t);
+}
+
+// an empty tree should freeze into an empty snapshot
+void test_freeze_empty(void) {
+  rbtree *t = new_rbtree();
+  rbtree_snapshot *s = rbtree_freeze(t);
+  assert(s->n == 0);
+  assert(rbtree_snapshot_find(s, 0) == NULL);
+  assert(rbtree_snapshot_lower_bound(s, 0) == NULL);
+  delete_rbtree_snapshot(s);
+  delete_rbtree(t);
+}
+
+// a counted tree freezes into the expanded multiset
+void test_freeze_counted(void) {
+  rbtree *t = new_rbtree_counted();
+  for (int i = 0; i < 100; i++) {
+    rbtree_insert(t, i % 7);
+  }
+  rbtree_snapshot *s = rbtree_freeze(t);
+  assert(s->n == 100);
+  for (key_t key = 0; key < 7; key++) {
+    assert(*rbtree_snapshot_find(s, key) == key);
+  }
+  assert(rbtree_snapshot_find(s, 7) == NULL);
+  delete_rbtree_snapshot(s);
+  delete_rbtree(t);
+}
+
+int main(void) {
+  test_freeze_empty();
+  test_freeze_counted();
+  for (size_t n = 1; n <= 40; n++) {
+    test_freeze(n, n);
+  }
+  test_freeze(10000, 5);
+  printf("Passed all tests!\n");
+}
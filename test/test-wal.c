@@ -0,0 +1,253 @@
+#include <assert.h>
+#include <errno.h>
+#include <rbtree_disk.h>
+#include <rbtree_wal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static char path[64], snap_path[80];
+
+static void make_path(void) {
+  snprintf(path, sizeof(path), "/tmp/test-wal-%d.log", (int)getpid());
+  snprintf(snap_path, sizeof(snap_path), "%s.snap", path);
+}
+
+static void remove_files(void) {
+  unlink(path);
+  unlink(snap_path);
+}
+
+static long file_size(const char *p) {
+  struct stat st;
+  assert(stat(p, &st) == 0);
+  return (long)st.st_size;
+}
+
+static void check_same(const rbtree *a, const rbtree *b) {
+  const size_t n = rbtree_size(b);
+  assert(rbtree_size(a) == n);
+
+  key_t *x = calloc(n + 1, sizeof(key_t));
+  key_t *y = calloc(n + 1, sizeof(key_t));
+  rbtree_to_array(a, x, n);
+  rbtree_to_array(b, y, n);
+  for (int i = 0; i < n; i++) {
+    assert(x[i] == y[i]);
+  }
+  free(y);
+  free(x);
+}
+
+// the same random operations on the logged tree and on a reference tree.
+// without a log only the reference tree is updated.
+static void random_ops(rbtree_wal *w, rbtree *ref, const size_t n) {
+  for (int i = 0; i < n; i++) {
+    const key_t key = rand() % 500;
+    if (rand() % 3 == 0) {
+      node_t *p = rbtree_find(ref, key);
+      assert(w == NULL || rbtree_wal_erase(w, key) == (p != NULL));
+      if (p != NULL) {
+        rbtree_erase(ref, p);
+      }
+    } else {
+      assert(w == NULL || rbtree_wal_insert(w, key)->key == key);
+      rbtree_insert(ref, key);
+    }
+  }
+}
+
+// a closed log replays into the same tree, in both sync modes
+void test_replay(const uint64_t interval_us, const unsigned int seed) {
+  srand(seed);
+  remove_files();
+  rbtree *ref = new_rbtree();
+
+  rbtree_wal *w = rbtree_wal_open(path, interval_us);
+  assert(w != NULL && rbtree_size(w->tree) == 0);
+  random_ops(w, ref, 3000);
+  check_same(w->tree, ref);
+  assert(rbtree_wal_close(w) == 0);
+
+  w = rbtree_wal_open(path, interval_us);
+  assert(w != NULL);
+  check_same(w->tree, ref);
+  random_ops(w, ref, 3000);
+  assert(rbtree_wal_close(w) == 0);
+
+  w = rbtree_wal_open(path, interval_us);
+  check_same(w->tree, ref);
+  assert(rbtree_wal_close(w) == 0);
+
+  delete_rbtree(ref);
+  remove_files();
+}
+
+// a process that dies keeps everything up to its last sync and nothing after it
+void test_crash(void) {
+  remove_files();
+  rbtree *ref = new_rbtree();
+
+  const pid_t pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    srand(7);
+    rbtree_wal *w = rbtree_wal_open(path, 60 * 1000000);
+    random_ops(w, ref, 20000);
+    assert(rbtree_wal_sync(w) == 0);
+    for (int i = 0; i < 100; i++) {
+      rbtree_wal_insert(w, 100000 + i);
+    }
+    _exit(0);
+  }
+  int status;
+  assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  srand(7);
+  random_ops(NULL, ref, 20000);
+  rbtree_wal *w = rbtree_wal_open(path, 0);
+  assert(w != NULL);
+  check_same(w->tree, ref);
+  assert(rbtree_find(w->tree, 100000) == NULL);
+  assert(rbtree_wal_close(w) == 0);
+
+  delete_rbtree(ref);
+  remove_files();
+}
+
+// a torn last block is dropped and cut off the log; the blocks before it survive
+void test_torn_tail(void) {
+  remove_files();
+  rbtree_wal *w = rbtree_wal_open(path, 60 * 1000000);
+  for (int i = 0; i < 100; i++) {
+    rbtree_wal_insert(w, i);
+  }
+  assert(rbtree_wal_sync(w) == 0);
+  const long synced = file_size(path);
+  for (int i = 100; i < 200; i++) {
+    rbtree_wal_insert(w, i);
+  }
+  assert(rbtree_wal_close(w) == 0);
+  assert(file_size(path) == synced + 8 + 100 * (long)RBTREE_WAL_RECORD);
+
+  assert(truncate(path, file_size(path) - 3) == 0);
+  w = rbtree_wal_open(path, 0);
+  assert(w != NULL && rbtree_size(w->tree) == 100);
+  assert(rbtree_max(w->tree)->key == 99);
+  assert(file_size(path) == synced);
+
+  // the log keeps growing from the cut
+  rbtree_wal_insert(w, 1000);
+  assert(rbtree_wal_close(w) == 0);
+
+  // a damaged record fails its block checksum
+  FILE *f = fopen(path, "r+b");
+  assert(f != NULL);
+  assert(fseek(f, synced + 8 + 1, SEEK_SET) == 0);
+  fputc(0x55, f);
+  fclose(f);
+  w = rbtree_wal_open(path, 0);
+  assert(w != NULL && rbtree_size(w->tree) == 100);
+  assert(rbtree_wal_close(w) == 0);
+
+  // a foreign file is not taken for a log
+  f = fopen(path, "wb");
+  assert(f != NULL);
+  fputs("not a write-ahead log at all", f);
+  fclose(f);
+  assert(rbtree_wal_open(path, 0) == NULL);
+
+  remove_files();
+}
+
+// a checkpoint moves the tree into the snapshot and empties the log
+void test_checkpoint(void) {
+  srand(11);
+  remove_files();
+  rbtree *ref = new_rbtree();
+
+  rbtree_wal *w = rbtree_wal_open(path, 1000);
+  random_ops(w, ref, 5000);
+  assert(rbtree_wal_checkpoint(w) == 0);
+  assert(file_size(path) == (long)sizeof(rbtree_wal_header));
+  rbtree_mapped *m = rbtree_load_mmap(snap_path);
+  assert(m != NULL && rbtree_mapped_size(m) == rbtree_size(ref));
+  delete_rbtree_mapped(m);
+  random_ops(w, ref, 1000);
+  assert(rbtree_wal_close(w) == 0);
+
+  w = rbtree_wal_open(path, 1000);
+  check_same(w->tree, ref);
+
+  // keep the log as it was right before the next checkpoint
+  assert(rbtree_wal_sync(w) == 0);
+  const long len = file_size(path);
+  char *old = malloc(len);
+  FILE *f = fopen(path, "rb");
+  assert(f != NULL && fread(old, 1, len, f) == len);
+  fclose(f);
+  random_ops(w, ref, 0);
+  assert(rbtree_wal_checkpoint(w) == 0);
+  assert(rbtree_wal_close(w) == 0);
+
+  // a crash between the snapshot and the new log leaves the old log behind;
+  // its records are already in the snapshot and must not be applied twice
+  f = fopen(path, "wb");
+  assert(f != NULL && fwrite(old, 1, len, f) == len);
+  fclose(f);
+  free(old);
+  w = rbtree_wal_open(path, 0);
+  assert(w != NULL);
+  check_same(w->tree, ref);
+  assert(file_size(path) == (long)sizeof(rbtree_wal_header));
+  assert(rbtree_wal_close(w) == 0);
+
+  // a damaged snapshot is an error, not an empty tree
+  f = fopen(snap_path, "r+b");
+  assert(f != NULL);
+  fputc('X', f);
+  fclose(f);
+  assert(rbtree_wal_open(path, 0) == NULL);
+
+  delete_rbtree(ref);
+  remove_files();
+}
+
+// once the log has failed, operations report it and leave the tree alone
+void test_failed_log(void) {
+  remove_files();
+  rbtree_wal *w = rbtree_wal_open(path, 0);
+  assert(w != NULL);
+  assert(rbtree_wal_insert(w, 1) != NULL);
+
+  w->error = EIO;
+  errno = 0;
+  assert(rbtree_wal_insert(w, 2) == NULL && errno == EIO);
+  errno = 0;
+  assert(rbtree_wal_erase(w, 1) == -1 && errno == EIO);
+  assert(rbtree_wal_erase(w, 3) == -1);
+  assert(rbtree_size(w->tree) == 1 && rbtree_find(w->tree, 1) != NULL);
+  assert(rbtree_wal_sync(w) == -1 && rbtree_wal_checkpoint(w) == -1);
+  assert(rbtree_wal_close(w) == -1 && errno == EIO);
+
+  // only the operation made before the failure was logged
+  w = rbtree_wal_open(path, 0);
+  assert(w != NULL && rbtree_size(w->tree) == 1 && rbtree_find(w->tree, 1) != NULL);
+  assert(rbtree_wal_close(w) == 0);
+  remove_files();
+}
+
+int main(void) {
+  make_path();
+  test_replay(0, 1);
+  test_replay(1000, 2);
+  test_replay(60 * 1000000, 3);
+  test_crash();
+  test_torn_tail();
+  test_checkpoint();
+  test_failed_log();
+  printf("Passed all tests!\n");
+}